@@ -105,14 +105,6 @@ cv::Mat BarcodeDetector::extractBarcodeRegion(const cv::RotatedRect& barcodeRect
     // 截取条形码区域
     cv::Mat barcodeImg;
     if (std::abs(angle) > 5.0) {
-        // 计算旋转中心
-        cv::Point2f center = barcodeRect.center;
-        cv::Mat rotMat = cv::getRotationMatrix2D(center, angle, 1.0);
-
-        // 执行旋转
-        cv::Mat rotatedImg;
-        cv::warpAffine(resizedSrc, rotatedImg, rotMat, resizedSrc.size(), cv::INTER_CUBIC);
-
         // 定义旋转矩形的四个顶点
         cv::Point2f vertices[4];
         barcodeRect.points(vertices);
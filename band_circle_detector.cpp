@@ -0,0 +1,275 @@
+#include "band_circle_detector.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TXMA_BAND_SSE2 1
+#endif
+
+namespace BandCircleDetector {
+
+    namespace {
+
+        // 梯度方向量化级数（2 的幂），半径 20 时相邻方向的偏移差约 1 像素
+        constexpr int kDirectionBins = 128;
+
+        // Canny 同款非极大值抑制的方向判定常数：tan(22.5°) * 2^15
+        constexpr int kTan22 = 13573;
+
+        struct Candidate {
+            int index;   // 累加器单元下标
+            int votes;   // 总票数
+        };
+
+        // 每个线程复用的缓冲区，尺寸不变时不重新分配
+        struct Workspace {
+            int table_min_radius = -1;
+            int table_max_radius = -1;
+            std::vector<cv::Point> offsets;     // [半径序号 * kDirectionBins + 方向] 的圆心偏移
+            std::vector<int16_t> dx, dy;        // 三行 Sobel 梯度环形缓冲
+            std::vector<int16_t> magnitude;     // 三行 L1 梯度幅值环形缓冲
+            std::vector<uint16_t> votes;        // [单元 * 半径数 + 半径序号]
+            std::vector<int> totals;            // 每个单元的总票数
+            std::vector<Candidate> candidates;
+        };
+
+        // 按半径带构建偏移表：方向 d 上半径 r 的圆心相对边缘点的偏移
+        void BuildOffsets(Workspace& ws, int min_radius, int max_radius) {
+            if (ws.table_min_radius == min_radius && ws.table_max_radius == max_radius) return;
+            const int radii = max_radius - min_radius + 1;
+            ws.offsets.resize(static_cast<size_t>(radii) * kDirectionBins);
+            for (int ri = 0; ri < radii; ++ri) {
+                for (int d = 0; d < kDirectionBins; ++d) {
+                    const double angle = 2 * CV_PI * d / kDirectionBins;
+                    const double r = min_radius + ri;
+                    ws.offsets[ri * kDirectionBins + d] = cv::Point(cvRound(r * std::cos(angle)), cvRound(r * std::sin(angle)));
+                }
+            }
+            ws.table_min_radius = min_radius;
+            ws.table_max_radius = max_radius;
+        }
+
+        // 一行 3x3 Sobel 梯度和 L1 幅值，左右边界置零
+        void SobelRow(const uchar* up, const uchar* mid, const uchar* down,
+                      int16_t* gx, int16_t* gy, int16_t* mag, int cols) {
+            gx[0] = gy[0] = mag[0] = 0;
+            gx[cols - 1] = gy[cols - 1] = mag[cols - 1] = 0;
+            int x = 1;
+#if defined(TXMA_BAND_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            auto load = [&](const uchar* p) {
+                return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+            };
+            for (; x + 8 <= cols - 1; x += 8) {
+                const __m128i ul = load(up + x - 1), uc = load(up + x), ur = load(up + x + 1);
+                const __m128i ml = load(mid + x - 1), mr = load(mid + x + 1);
+                const __m128i dl = load(down + x - 1), dc = load(down + x), dr = load(down + x + 1);
+                const __m128i sx = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(ur, dr), _mm_slli_epi16(mr, 1)),
+                                                 _mm_add_epi16(_mm_add_epi16(ul, dl), _mm_slli_epi16(ml, 1)));
+                const __m128i sy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(dl, dr), _mm_slli_epi16(dc, 1)),
+                                                 _mm_add_epi16(_mm_add_epi16(ul, ur), _mm_slli_epi16(uc, 1)));
+                const __m128i ax = _mm_max_epi16(sx, _mm_sub_epi16(zero, sx));
+                const __m128i ay = _mm_max_epi16(sy, _mm_sub_epi16(zero, sy));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(gx + x), sx);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(gy + x), sy);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(mag + x), _mm_add_epi16(ax, ay));
+            }
+#endif
+            for (; x < cols - 1; ++x) {
+                const int sx = (up[x + 1] + 2 * mid[x + 1] + down[x + 1]) - (up[x - 1] + 2 * mid[x - 1] + down[x - 1]);
+                const int sy = (down[x - 1] + 2 * down[x] + down[x + 1]) - (up[x - 1] + 2 * up[x] + up[x + 1]);
+                gx[x] = static_cast<int16_t>(sx);
+                gy[x] = static_cast<int16_t>(sy);
+                mag[x] = static_cast<int16_t>(std::abs(sx) + std::abs(sy));
+            }
+        }
+
+        // 梯度方向的量化级（0 ~ kDirectionBins - 1），多项式近似 atan2，误差约 0.005 弧度（远小于一级）
+        int DirectionBin(int gx, int gy) {
+            const float ax = static_cast<float>(std::abs(gx));
+            const float ay = static_cast<float>(std::abs(gy));
+            if (ax == 0 && ay == 0) return 0;
+            const float t = std::min(ax, ay) / std::max(ax, ay);
+            float angle = t * (static_cast<float>(CV_PI / 4) + 0.273f * (1 - t));  // atan(t)，t ∈ [0, 1]
+            if (ay > ax) angle = static_cast<float>(CV_PI / 2) - angle;
+            if (gx < 0) angle = static_cast<float>(CV_PI) - angle;
+            if (gy < 0) angle = -angle;
+            constexpr float kBinsPerRadian = static_cast<float>(kDirectionBins / (2 * CV_PI));
+            return static_cast<int>(std::lround(angle * kBinsPerRadian)) & (kDirectionBins - 1);
+        }
+
+        // 下一个幅值不低于 threshold 的位置，不存在时返回 end
+        int NextAboveThreshold(const int16_t* mag, int x, int end, int16_t threshold) {
+#if defined(TXMA_BAND_SSE2)
+            const __m128i limit = _mm_set1_epi16(static_cast<short>(threshold - 1));
+            while (x + 8 <= end) {
+                const int mask = _mm_movemask_epi8(_mm_cmpgt_epi16(
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(mag + x)), limit));
+                if (mask) {
+                    while (mag[x] < threshold) ++x;
+                    return x;
+                }
+                x += 8;
+            }
+#endif
+            while (x < end && mag[x] < threshold) ++x;
+            return x;
+        }
+
+        // 沿梯度方向的非极大值抑制（与 Canny 相同的四方向量化），up/mid/down 指向同一列的三行幅值
+        bool IsEdgeMaximum(const int16_t* up, const int16_t* mid, const int16_t* down, int gx, int gy) {
+            const int m = mid[0];
+            const int ax = std::abs(gx);
+            const int ay = std::abs(gy) << 15;
+            const int tg22 = ax * kTan22;
+            if (ay < tg22) return m > mid[-1] && m >= mid[1];
+            const int tg67 = tg22 + (ax << 16);
+            if (ay > tg67) return m > up[0] && m >= down[0];
+            const int s = (gx ^ gy) < 0 ? -1 : 1;
+            return m > up[-s] && m >= down[s];
+        }
+
+    }  // namespace
+
+    void DetectCircles(const cv::Mat& gray, std::vector<cv::Vec3f>& circles, double dp, double min_dist,
+                       double edge_threshold, double votes_threshold, int min_radius, int max_radius) {
+        TXMA_TRACE_SCOPE("BandCircleDetector.DetectCircles");
+        CV_Assert(gray.type() == CV_8UC1);
+        circles.clear();
+        min_radius = std::max(min_radius, 1);
+        max_radius = std::max(max_radius, min_radius);
+        const int radii = max_radius - min_radius + 1;
+        CV_Assert(radii <= kMaxRadiusBand);
+        if (gray.cols < 3 || gray.rows < 3) return;
+
+        thread_local Workspace ws;
+        BuildOffsets(ws, min_radius, max_radius);
+
+        const int cols = gray.cols, rows = gray.rows;
+        const int step = std::max(1, cvRound(dp));
+        const int acc_cols = (cols + step - 1) / step;
+        const int acc_rows = (rows + step - 1) / step;
+        ws.votes.assign(static_cast<size_t>(acc_cols) * acc_rows * radii, 0);
+        ws.totals.assign(static_cast<size_t>(acc_cols) * acc_rows, 0);
+        ws.dx.assign(static_cast<size_t>(cols) * 3, 0);
+        ws.dy.assign(static_cast<size_t>(cols) * 3, 0);
+        ws.magnitude.assign(static_cast<size_t>(cols) * 3, 0);
+        auto ring = [&](std::vector<int16_t>& buffer, int y) { return buffer.data() + static_cast<size_t>(y % 3) * cols; };
+
+        // 逐行计算梯度：第 y + 1 行就绪后对第 y 行做非极大值抑制和投票，梯度只保留三行
+        // 每个边缘点沿梯度正反两个方向，为半径带内每个半径各投一票，同时累计单元总票数
+        {
+            TXMA_TRACE_SCOPE("BandCircleDetector.GradientVote");
+            const auto threshold = static_cast<int16_t>(std::clamp(std::ceil(edge_threshold), 1.0, 32767.0));
+            uint16_t* votes = ws.votes.data();
+            int* totals = ws.totals.data();
+            for (int y = 1; y < rows - 1; ++y) {
+                const int next = y + 1;
+                if (next < rows - 1) {
+                    SobelRow(gray.ptr<uchar>(next - 1), gray.ptr<uchar>(next), gray.ptr<uchar>(next + 1),
+                             ring(ws.dx, next), ring(ws.dy, next), ring(ws.magnitude, next), cols);
+                } else {
+                    std::fill(ring(ws.magnitude, next), ring(ws.magnitude, next) + cols, int16_t(0));
+                }
+                if (y == 1) {
+                    SobelRow(gray.ptr<uchar>(0), gray.ptr<uchar>(1), gray.ptr<uchar>(2),
+                             ring(ws.dx, 1), ring(ws.dy, 1), ring(ws.magnitude, 1), cols);
+                    std::fill(ring(ws.magnitude, 0), ring(ws.magnitude, 0) + cols, int16_t(0));
+                }
+
+                const int16_t* mag = ring(ws.magnitude, y);
+                const int16_t* gx_row = ring(ws.dx, y);
+                const int16_t* gy_row = ring(ws.dy, y);
+                const int16_t* mag_up = ring(ws.magnitude, y - 1);
+                const int16_t* mag_down = ring(ws.magnitude, y + 1);
+                for (int x = NextAboveThreshold(mag, 1, cols - 1, threshold); x < cols - 1;
+                     x = NextAboveThreshold(mag, x + 1, cols - 1, threshold)) {
+                    const int gx = gx_row[x], gy = gy_row[x];
+                    if (!IsEdgeMaximum(mag_up + x, mag + x, mag_down + x, gx, gy)) continue;
+
+                    const int d = DirectionBin(gx, gy);
+                    for (int ri = 0; ri < radii; ++ri) {
+                        const cv::Point offset = ws.offsets[ri * kDirectionBins + d];
+                        for (const int sign : {1, -1}) {
+                            const int cx = x + sign * offset.x;
+                            const int cy = y + sign * offset.y;
+                            if (static_cast<unsigned>(cx) >= static_cast<unsigned>(cols) ||
+                                static_cast<unsigned>(cy) >= static_cast<unsigned>(rows)) continue;
+                            const size_t cell = static_cast<size_t>(cy / step) * acc_cols + cx / step;
+                            uint16_t& vote = votes[cell * radii + ri];
+                            if (vote != UINT16_MAX) {
+                                ++vote;
+                                ++totals[cell];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // 圆心候选：总票数超过阈值的局部极大值（与 HoughCircles 相同的四邻域判定）
+        ws.candidates.clear();
+        const int* totals = ws.totals.data();
+        for (int ay = 1; ay < acc_rows - 1; ++ay) {
+            for (int ax = 1; ax < acc_cols - 1; ++ax) {
+                const int i = ay * acc_cols + ax;
+                const int t = totals[i];
+                if (t > votes_threshold && t > totals[i - 1] && t >= totals[i + 1] &&
+                    t > totals[i - acc_cols] && t >= totals[i + acc_cols]) {
+                    ws.candidates.push_back({i, t});
+                }
+            }
+        }
+        std::stable_sort(ws.candidates.begin(), ws.candidates.end(),
+                         [](const Candidate& a, const Candidate& b) { return a.votes > b.votes; });
+
+        // 按票数依次接受，与已接受圆心距离小于 min_dist 的丢弃
+        const double min_dist2 = min_dist * min_dist;
+        std::vector<int> radius_votes(radii);
+        for (const Candidate& candidate : ws.candidates) {
+            const int ax = candidate.index % acc_cols;
+            const int ay = candidate.index / acc_cols;
+
+            // 3x3 邻域加权求圆心，同时累计各半径票数
+            double sum = 0, sum_x = 0, sum_y = 0;
+            std::fill(radius_votes.begin(), radius_votes.end(), 0);
+            for (int ny = ay - 1; ny <= ay + 1; ++ny) {
+                for (int nx = ax - 1; nx <= ax + 1; ++nx) {
+                    const int ni = ny * acc_cols + nx;
+                    sum += totals[ni];
+                    sum_x += static_cast<double>(totals[ni]) * nx;
+                    sum_y += static_cast<double>(totals[ni]) * ny;
+                    const uint16_t* cell = ws.votes.data() + static_cast<size_t>(ni) * radii;
+                    for (int ri = 0; ri < radii; ++ri) radius_votes[ri] += cell[ri];
+                }
+            }
+            const float x = static_cast<float>((sum_x / sum + 0.5) * step);
+            const float y = static_cast<float>((sum_y / sum + 0.5) * step);
+
+            bool too_close = false;
+            for (const auto& accepted : circles) {
+                const double ddx = accepted[0] - x, ddy = accepted[1] - y;
+                if (ddx * ddx + ddy * ddy < min_dist2) {
+                    too_close = true;
+                    break;
+                }
+            }
+            if (too_close) continue;
+
+            // 半径取票数最多者，并用相邻半径的票数做抛物线插值
+            const int best = static_cast<int>(std::max_element(radius_votes.begin(), radius_votes.end()) - radius_votes.begin());
+            double radius = min_radius + best;
+            if (best > 0 && best < radii - 1) {
+                const double left = radius_votes[best - 1], center = radius_votes[best], right = radius_votes[best + 1];
+                const double denom = left - 2 * center + right;
+                if (denom < 0) radius += std::clamp(0.5 * (left - right) / denom, -0.5, 0.5);
+            }
+            circles.emplace_back(x, y, static_cast<float>(radius));
+        }
+    }
+
+}  // namespace BandCircleDetector
\ No newline at end of file
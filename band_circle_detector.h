@@ -0,0 +1,23 @@
+#ifndef BAND_CIRCLE_DETECTOR_H
+#define BAND_CIRCLE_DETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace BandCircleDetector {
+
+    // 可用专用检测的最大半径带宽（max_radius - min_radius + 1），更宽时调用方应使用 cv::HoughCircles
+    constexpr int kMaxRadiusBand = 16;
+
+    // 窄半径带圆检测，参数含义与 cv::HoughCircles(HOUGH_GRADIENT) 相同：
+    //   dp 为累加器分辨率（取整数）、min_dist 为圆心最小间距、
+    //   edge_threshold 为边缘梯度阈值（Sobel L1 幅值，对应 param1）、votes_threshold 为圆心票数阈值（对应 param2）
+    // 不做 Canny 和半径直方图估计：梯度幅值非极大值抑制后，按量化的梯度方向查每个半径的预计算偏移表投票，
+    // 累加器每个单元连续存放半径带内各半径的票数，圆心取总票数局部极大值，半径取该单元票数最多的半径
+    // gray 必须为 CV_8UC1（通常已滤波）；结果按票数从高到低排列
+    void DetectCircles(const cv::Mat& gray, std::vector<cv::Vec3f>& circles, double dp, double min_dist,
+                       double edge_threshold, double votes_threshold, int min_radius, int max_radius);
+
+}  // namespace BandCircleDetector
+
+#endif  // BAND_CIRCLE_DETECTOR_H
\ No newline at end of file
@@ -1,82 +1,243 @@
 #include "barcode.h"
+#include "fast_morphology.h"
+#include "fused_gradient.h"
+#include "trace.h"
+#include <algorithm>
 #include <iostream>
 
-BarcodeDetector::BarcodeDetector(const std::string& image_path) {
-    src_ = cv::imread(image_path);
+BarcodeDetector::BarcodeDetector(const BarcodeParams& params) : params_(params) {}
+
+BarcodeDetector::BarcodeDetector(const std::string& image_path, const BarcodeParams& params) : params_(params) {
+    {
+        TXMA_TRACE_SCOPE("BarcodeDetector.imread");
+        src_ = cv::imread(image_path);
+    }
     if (src_.empty()) {
         throw std::runtime_error("Error: Unable to load image!");
     }
-    cv::resize(src_, resized_src_, cv::Size(600, 400));  // 调整图像大小
+    BuildPyramid(src_);
+}
+
+BarcodeResult BarcodeDetector::Detect(const cv::Mat& frame) {
+    TXMA_TRACE_SCOPE("BarcodeDetector.Detect");
+    BarcodeResult result;
+    if (frame.empty()) return result;
+
+    BuildPyramid(frame);
+    cv::RotatedRect coarse_rect;
+    if (!DetectBarcodeRegion(SegmentImage(pyramid_[coarse_level_], 1), coarse_rect)) return result;
+
+    result.rect = RefineRegion(coarse_rect);
+    result.crop = ExtractBarcodeRegion(result.rect, barcode_img_);
+    result.found = !result.crop.empty();
+    if (result.found && params_.decode) result.scan = DecodeBarcodeRegion(result.rect);
+    return result;
+}
+
+std::vector<BarcodeResult> BarcodeDetector::DetectAll(const cv::Mat& frame, ImageProcessor::WorkStealingPool* pool) {
+    TXMA_TRACE_SCOPE("BarcodeDetector.DetectAll");
+    std::vector<BarcodeResult> results;
+    if (frame.empty()) return results;
+
+    BuildPyramid(frame);
+    DetectBarcodeCandidates(SegmentImage(pyramid_[coarse_level_], 1), candidates_);
+    results.resize(candidates_.size());
+    if (crops_.size() < candidates_.size()) crops_.resize(candidates_.size());
+
+    // 细化复用检测器的中间缓冲区，逐个执行
+    for (cv::RotatedRect& candidate : candidates_) candidate = RefineRegion(candidate);
+
+    // 各区域只读共享的金字塔和原图，截取结果写入各自的缓冲区
+    if (!pool) pool = &ImageProcessor::WorkStealingPool::Shared();
+    pool->ParallelFor(candidates_.size(), [&](size_t index, int) {
+        BarcodeResult& result = results[index];
+        result.rect = candidates_[index];
+        result.crop = ExtractBarcodeRegion(result.rect, crops_[index]);
+        result.found = !result.crop.empty();
+        if (result.found && params_.decode) result.scan = DecodeBarcodeRegion(result.rect);
+    });
+
+    // 截取失败（退化矩形）的区域不返回
+    results.erase(std::remove_if(results.begin(), results.end(),
+                                 [](const BarcodeResult& result) { return !result.found; }),
+                  results.end());
+    return results;
+}
+
+void BarcodeDetector::BuildPyramid(const cv::Mat& frame) {
+    TXMA_TRACE_SCOPE("BarcodeDetector.BuildPyramid");
+    src_ = frame;
+    const int coarse_size = std::max(params_.coarse_size, 1);
+    int levels = 0;
+    while (std::max(src_.cols >> levels, src_.rows >> levels) > coarse_size &&
+           std::min(src_.cols >> (levels + 1), src_.rows >> (levels + 1)) > 0) {
+        ++levels;
+    }
+    coarse_level_ = levels;
+    refine_level_ = std::max(levels - std::max(params_.refine_levels, 0), 0);
+
+    // 细化层由原图按整数倍直接面积降采样（OpenCV INTER_AREA 整数倍的快速路径），更粗的层由上一层减半
+    // 各层取原图左上角 (cols >> i << i) x (rows >> i << i) 的范围，层间坐标严格按 2 的幂对应
+    pyramid_.resize(levels + 1);
+    pyramid_[0] = src_;
+    for (int level = 1; level <= levels; ++level) {
+        if (level < refine_level_) {
+            pyramid_[level].release();
+            continue;
+        }
+        const int from = level == refine_level_ ? 0 : level - 1;
+        const int factor = 1 << (level - from);
+        const cv::Size size(src_.cols >> level, src_.rows >> level);
+        const cv::Mat source = pyramid_[from](cv::Rect(0, 0, size.width * factor, size.height * factor));
+        cv::resize(source, pyramid_[level], size, 0, 0, cv::INTER_AREA);
+    }
+
+    // 各阶段默认在粗检测层上执行
+    search_image_ = pyramid_[coarse_level_];
+    morph_size_ = std::max(params_.morph_kernel, 1);
+}
+
+cv::Mat BarcodeDetector::SegmentImage(const cv::Mat& image, int scale) {
+    search_image_ = image;
+    // 放大后的边长保持奇数：偶数边长的锚点不在中心，闭运算/腐蚀/膨胀后区域会整体偏移
+    morph_size_ = std::max(params_.morph_kernel, 1) * scale;
+    if (scale > 1 && morph_size_ % 2 == 0) ++morph_size_;
+    const cv::Mat binary = EnhanceAndBinarize(PreprocessImage());
+    return MorphologicalOperations(binary);
+}
+
+cv::RotatedRect BarcodeDetector::RefineRegion(const cv::RotatedRect& coarse_rect) {
+    TXMA_TRACE_SCOPE("BarcodeDetector.RefineRegion");
+    const cv::RotatedRect fallback = ScaleRect(coarse_rect, coarse_level_, 0);
+    if (refine_level_ == coarse_level_) return fallback;
+
+    // 粗检测层上区域边缘可能被截断，外扩四分之一长边和两个结构元素
+    const int scale = 1 << (coarse_level_ - refine_level_);
+    const cv::Mat& level = pyramid_[refine_level_];
+    const cv::Rect box = ScaleRect(coarse_rect, coarse_level_, refine_level_).boundingRect();
+    const int margin = std::max(box.width, box.height) / 4 + 2 * std::max(params_.morph_kernel, 1) * scale;
+    const cv::Rect roi = cv::Rect(box.x - margin, box.y - margin, box.width + 2 * margin, box.height + 2 * margin) &
+                         cv::Rect(0, 0, level.cols, level.rows);
+    if (roi.empty()) return fallback;
+
+    cv::RotatedRect refined;
+    if (!DetectBarcodeRegion(SegmentImage(level(roi), scale), refined)) return fallback;
+    refined.center += cv::Point2f(static_cast<float>(roi.x), static_cast<float>(roi.y));
+    return ScaleRect(refined, refine_level_, 0);
+}
+
+cv::RotatedRect BarcodeDetector::ScaleRect(const cv::RotatedRect& rect, int from_level, int to_level) {
+    // 第 i 层像素 x 覆盖原图 [x * 2^i, (x + 1) * 2^i)，像素中心相差半个像素
+    const float factor = std::ldexp(1.0f, from_level - to_level);
+    const cv::Point2f center((rect.center.x + 0.5f) * factor - 0.5f, (rect.center.y + 0.5f) * factor - 0.5f);
+    return cv::RotatedRect(center, cv::Size2f(rect.size.width * factor, rect.size.height * factor), rect.angle);
 }
 
 cv::Mat BarcodeDetector::PreprocessImage() {
+    TXMA_TRACE_SCOPE("BarcodeDetector.PreprocessImage");
     // 转化为灰度图
-    cv::Mat gray;
-    cv::cvtColor(resized_src_, gray, cv::COLOR_BGR2GRAY);
+    if (search_image_.channels() == 1) {
+        gray_ = search_image_;
+    } else {
+        cv::cvtColor(search_image_, gray_, cv::COLOR_BGR2GRAY);
+    }
 
     // 高斯平滑滤波
-    cv::Mat blurred;
-    cv::GaussianBlur(gray, blurred, cv::Size(3, 3), 0);
+    cv::GaussianBlur(gray_, blurred_, cv::Size(3, 3), 0);
 
-    return blurred;
+    return blurred_;
 }
 
 cv::Mat BarcodeDetector::EnhanceAndBinarize(const cv::Mat& processed) {
+    TXMA_TRACE_SCOPE("BarcodeDetector.EnhanceAndBinarize");
+    if (params_.fused_gradient) {
+        FusedGradient::GradientThreshold(processed, binary_, params_.binary_threshold);
+        return binary_;
+    }
+
     // 使用Sobel算子求水平和垂直方向梯度差
-    cv::Mat grad_x, grad_y, gradient;
-    cv::Sobel(processed, grad_x, CV_16S, 1, 0, 3, 1, 0, 4);  // 水平梯度
-    cv::Sobel(processed, grad_y, CV_16S, 0, 1, 3, 1, 0, 4);  // 垂直梯度
-    cv::subtract(grad_x, grad_y, gradient);                  // 梯度差
-    cv::convertScaleAbs(gradient, gradient);                 // 转换为8位图像
+    cv::Sobel(processed, grad_x_, CV_16S, 1, 0, 3, 1, 0, 4);  // 水平梯度
+    cv::Sobel(processed, grad_y_, CV_16S, 0, 1, 3, 1, 0, 4);  // 垂直梯度
+    cv::subtract(grad_x_, grad_y_, grad_x_);                  // 梯度差
+    cv::convertScaleAbs(grad_x_, gradient_);                  // 转换为8位图像
 
     // 均值滤波，消除高频噪声
-    cv::Mat mean_filtered;
-    cv::blur(gradient, mean_filtered, cv::Size(3, 3));
+    cv::blur(gradient_, mean_filtered_, cv::Size(3, 3));
 
     // 二值化
-    cv::Mat binary;
-    cv::threshold(mean_filtered, binary, 90, 255, cv::THRESH_BINARY);
+    cv::threshold(mean_filtered_, binary_, params_.binary_threshold, 255, cv::THRESH_BINARY);
 
-    return binary;
+    return binary_;
 }
 
 cv::Mat BarcodeDetector::MorphologicalOperations(const cv::Mat& binary) {
+    TXMA_TRACE_SCOPE("BarcodeDetector.MorphologicalOperations");
+    if (params_.fast_morphology) {
+        FastMorphology::CloseErodeDilate(binary, dilated_, morph_size_);
+        return dilated_;
+    }
+
     // 闭运算，填充条形码间隙
-    cv::Mat closed;
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(7, 7));
-    cv::morphologyEx(binary, closed, cv::MORPH_CLOSE, kernel);
+    const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(morph_size_, morph_size_));
+    cv::morphologyEx(binary, closed_, cv::MORPH_CLOSE, kernel);
 
     // 腐蚀，去除孤立的点
-    cv::Mat eroded;
-    cv::morphologyEx(closed, eroded, cv::MORPH_ERODE, kernel);
+    cv::morphologyEx(closed_, eroded_, cv::MORPH_ERODE, kernel);
 
     // 膨胀，填充条形码间空隙
-    cv::Mat dilated;
-    cv::morphologyEx(eroded, dilated, cv::MORPH_DILATE, kernel);
-    cv::morphologyEx(eroded, dilated, cv::MORPH_DILATE, kernel);
+    cv::morphologyEx(eroded_, dilated_, cv::MORPH_DILATE, kernel);
 
-    return dilated;
+    return dilated_;
 }
 
-cv::RotatedRect BarcodeDetector::DetectBarcodeRegion(const cv::Mat& morph) {
+bool BarcodeDetector::DetectBarcodeRegion(const cv::Mat& morph, cv::RotatedRect& rect) {
+    TXMA_TRACE_SCOPE("BarcodeDetector.DetectBarcodeRegion");
     // 找到最大条形码区域
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(morph, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-    if (contours.empty()) {
-        throw std::runtime_error("No contours found!");
-    }
+    cv::findContours(morph, contours_, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    if (contours_.empty()) return false;
 
     // 获取最大轮廓的旋转矩形
-    cv::RotatedRect max_rect = cv::minAreaRect(contours[0]);
-    for (size_t i = 1; i < contours.size(); i++) {
-        cv::RotatedRect tmp = cv::minAreaRect(contours[i]);
-        if (tmp.size.area() > max_rect.size.area()) {
-            max_rect = tmp;
+    // 旋转矩形面积不超过轴对齐外接框面积，外接框不大于当前最大面积的轮廓（大部分噪声斑点）不求 minAreaRect
+    rect = cv::minAreaRect(contours_[0]);
+    for (size_t i = 1; i < contours_.size(); i++) {
+        if (static_cast<float>(cv::boundingRect(contours_[i]).area()) <= rect.size.area()) continue;
+        cv::RotatedRect tmp = cv::minAreaRect(contours_[i]);
+        if (tmp.size.area() > rect.size.area()) {
+            rect = tmp;
         }
     }
 
-    return max_rect;
+    return true;
+}
+
+void BarcodeDetector::DetectBarcodeCandidates(const cv::Mat& morph, std::vector<cv::RotatedRect>& rects) {
+    TXMA_TRACE_SCOPE("BarcodeDetector.DetectBarcodeCandidates");
+    // 外接框长边超过短边的该倍数视为线条或边缘
+    constexpr int kMaxBoxAspect = 12;
+    // 像素数占外接框的比例下限：45° 旋转的 3:1 矩形约为 0.375，更稀疏的是枝状噪声
+    constexpr double kMinFill = 0.3;
+
+    rects.clear();
+    const int count = cv::connectedComponentsWithStats(morph, labels_, stats_, centroids_, 8, CV_32S);
+    for (int label = 1; label < count; ++label) {
+        const int* stat = stats_.ptr<int>(label);
+        const int area = stat[cv::CC_STAT_AREA];
+        const cv::Rect box(stat[cv::CC_STAT_LEFT], stat[cv::CC_STAT_TOP], stat[cv::CC_STAT_WIDTH], stat[cv::CC_STAT_HEIGHT]);
+        if (area < params_.min_region_area) continue;
+        if (std::max(box.width, box.height) > kMaxBoxAspect * std::min(box.width, box.height)) continue;
+        if (area < kMinFill * box.area()) continue;
+
+        // 只在外接框内取出该连通域的外轮廓（连通域只有一条外轮廓）
+        cv::compare(labels_(box), label, component_mask_, cv::CMP_EQ);
+        cv::findContours(component_mask_, contours_, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, box.tl());
+        if (contours_.empty()) continue;
+        rects.push_back(cv::minAreaRect(contours_[0]));
+    }
+
+    std::sort(rects.begin(), rects.end(), [](const cv::RotatedRect& a, const cv::RotatedRect& b) {
+        return a.size.area() > b.size.area();
+    });
+    if (rects.size() > static_cast<size_t>(std::max(params_.max_regions, 0))) rects.resize(params_.max_regions);
 }
 
 void BarcodeDetector::DrawBarcodeBox(cv::Mat& display_img, const cv::RotatedRect& barcode_rect) {
@@ -87,7 +248,11 @@ void BarcodeDetector::DrawBarcodeBox(cv::Mat& display_img, const cv::RotatedRect
     }
 }
 
-cv::Mat BarcodeDetector::ExtractBarcodeRegion(const cv::RotatedRect& barcode_rect) {
+cv::Mat BarcodeDetector::ExtractBarcodeRegion(const cv::RotatedRect& source_rect, cv::Mat& buffer) const {
+    TXMA_TRACE_SCOPE("BarcodeDetector.ExtractBarcodeRegion");
+    const cv::Mat& image = pyramid_[refine_level_];
+    const cv::RotatedRect barcode_rect = ScaleRect(source_rect, 0, refine_level_);
+
     // 获取旋转矩形的角度和尺寸
     float angle = barcode_rect.angle;
     cv::Size2f rect_size = barcode_rect.size;
@@ -101,18 +266,10 @@ cv::Mat BarcodeDetector::ExtractBarcodeRegion(const cv::RotatedRect& barcode_rec
     if (angle > 90.0f) {
         angle -= 180.0f;
     }
+    if (rect_size.width < 1.0f || rect_size.height < 1.0f) return cv::Mat();
 
     // 截取条形码区域
-    cv::Mat barcode_img;
     if (std::abs(angle) > 5.0) {
-        // 计算旋转中心
-        cv::Point2f center = barcode_rect.center;
-        cv::Mat rot_mat = cv::getRotationMatrix2D(center, angle, 1.0);
-
-        // 执行旋转
-        cv::Mat rotated_img;
-        cv::warpAffine(resized_src_, rotated_img, rot_mat, resized_src_.size(), cv::INTER_CUBIC);
-
         // 定义旋转矩形的四个顶点
         cv::Point2f vertices[4];
         barcode_rect.points(vertices);
@@ -130,35 +287,54 @@ cv::Mat BarcodeDetector::ExtractBarcodeRegion(const cv::RotatedRect& barcode_rec
         cv::Mat perspective_mat = cv::getPerspectiveTransform(src_points, dst_points);
 
         // 执行透视变换
-        cv::warpPerspective(resized_src_, barcode_img, perspective_mat, cv::Size(rect_size.width, rect_size.height));
-    } else {
-        // 直接截取原始区域
-        barcode_img = resized_src_(barcode_rect.boundingRect());
+        cv::warpPerspective(image, buffer, perspective_mat, cv::Size(rect_size.width, rect_size.height));
+        return buffer;
     }
 
-    return barcode_img;
+    // 直接截取原始区域（裁剪到图像范围内，返回视图）
+    const cv::Rect bounds = barcode_rect.boundingRect() & cv::Rect(0, 0, image.cols, image.rows);
+    return bounds.empty() ? cv::Mat() : image(bounds);
 }
 
-void BarcodeDetector::DetectBarcode() {
-    // 图像预处理
-    cv::Mat processed = PreprocessImage();
-
-    // 梯度增强与二值化
-    cv::Mat binary = EnhanceAndBinarize(processed);
+BarcodeDecoder::ScanResult BarcodeDetector::DecodeBarcodeRegion(const cv::RotatedRect& barcode_rect) const {
+    TXMA_TRACE_SCOPE("BarcodeDetector.DecodeBarcodeRegion");
+    // 检测在降采样层上进行，扫描线在原图上采样以保留条空细节
+    cv::Point2f vertices[4];
+    barcode_rect.points(vertices);
+    std::array<cv::Point2f, 4> corners;
+    std::copy(vertices, vertices + 4, corners.begin());
+    return BarcodeDecoder::DecodeRegion(src_, corners, params_.scanlines);
+}
 
-    // 形态学操作
-    cv::Mat morph = MorphologicalOperations(binary);
+void BarcodeDetector::DetectBarcode() {
+    // 粗检测层上预处理、梯度增强与二值化、形态学操作
+    cv::Mat morph = SegmentImage(pyramid_[coarse_level_], 1);
 
-    // 检测条形码区域
-    cv::RotatedRect barcode_rect = DetectBarcodeRegion(morph);
+    // 检测条形码区域，并在细化层上求精
+    cv::RotatedRect coarse_rect;
+    if (!DetectBarcodeRegion(morph, coarse_rect)) {
+        throw std::runtime_error("No contours found!");
+    }
+    const cv::RotatedRect barcode_rect = RefineRegion(coarse_rect);
 
-    // 在原图上绘制条形码框
-    cv::Mat display_img = resized_src_.clone();
-    DrawBarcodeBox(display_img, barcode_rect);
+    // 在粗检测层上绘制条形码框
+    cv::Mat display_img = pyramid_[coarse_level_].clone();
+    DrawBarcodeBox(display_img, ScaleRect(barcode_rect, 0, coarse_level_));
     cv::imshow("Original Image with Barcode Box", display_img);
 
+    // 解码
+    if (params_.decode) {
+        const BarcodeDecoder::ScanResult scan = DecodeBarcodeRegion(barcode_rect);
+        if (scan.decoded) {
+            std::cout << BarcodeDecoder::SymbologyName(scan.symbology) << ": " << scan.text
+                      << " (confidence " << scan.confidence << ")" << std::endl;
+        } else {
+            std::cout << "Barcode not decoded" << std::endl;
+        }
+    }
+
     // 截取条形码区域
-    cv::Mat barcode_img = ExtractBarcodeRegion(barcode_rect);
+    cv::Mat barcode_img = ExtractBarcodeRegion(barcode_rect, barcode_img_);
     if (!barcode_img.empty()) {
         cv::namedWindow("Extracted Barcode", cv::WINDOW_NORMAL);
         cv::resizeWindow("Extracted Barcode", barcode_img.cols, barcode_img.rows);
@@ -4,18 +4,60 @@
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <vector>
+#include "barcode_decoder.h"
+#include "work_stealing_pool.h"
+
+// 条形码检测参数
+struct BarcodeParams {
+    bool fused_gradient = true;  // 梯度差/均值/二值化一次逐行扫描完成（结果与 OpenCV 链路一致），关闭时逐步调用 OpenCV
+    int binary_threshold = 90;   // 梯度均值的二值化阈值
+    bool fast_morphology = true; // 闭运算/腐蚀/膨胀一次流式扫描完成（结果与 OpenCV 一致），关闭时逐步调用 OpenCV
+    int morph_kernel = 7;        // 形态学矩形结构元素边长（粗检测层），细化层按层间倍数放大
+    int coarse_size = 640;       // 粗检测层长边上限：原图保持宽高比按 2 倍逐层降采样，直到长边不超过该值
+    int refine_levels = 1;       // 在候选区域内向细层细化的层数，0 表示直接使用粗检测结果
+    bool decode = true;          // 沿检测区域在原图上采样扫描线解码（EAN-13 / Code 128）
+    int scanlines = 5;           // 解码用的平行扫描线条数
+    int min_region_area = 400;   // DetectAll：候选连通域的最小像素数（粗检测层坐标）
+    int max_regions = 16;        // DetectAll：最多返回的区域数（按面积从大到小）
+};
+
+// 单帧条形码检测结果
+struct BarcodeResult {
+    bool found = false;      // 是否找到条形码区域
+    cv::RotatedRect rect;    // 条形码区域（原图坐标）
+    cv::Mat crop;            // 截取的条形码图像（细化层分辨率），引用检测器内部缓冲区，下一次 Detect 前有效
+    BarcodeDecoder::ScanResult scan;  // 扫描线解码结果（未找到区域或关闭解码时 decoded 为 false）
+};
 
 // 条形码检测器类，用于检测图像中的条形码并提取条形码区域
+// 每帧构建一次图像金字塔：在粗检测层上找候选区域，再只在候选区域内于细化层重新做梯度/形态学求精确区域
+// 长期持有同一个检测器逐帧调用 Detect，各阶段的中间图像缓冲区在帧间复用
 class BarcodeDetector {
 public:
-    // 构造函数，接受图像路径作为参数
-    explicit BarcodeDetector(const std::string& image_path);
+    // 流式检测用的构造函数，不加载图像
+    explicit BarcodeDetector(const BarcodeParams& params = BarcodeParams());
 
-    // 检测条形码并显示结果
+    // 构造函数，接受图像路径作为参数，读取失败抛出 std::runtime_error
+    explicit BarcodeDetector(const std::string& image_path, const BarcodeParams& params = BarcodeParams());
+
+    // 检测一帧（BGR 或灰度），不显示窗口、不抛出异常；frame 在返回结果使用完之前不得修改
+    BarcodeResult Detect(const cv::Mat& frame);
+
+    // 检测一帧中的全部条形码区域（按面积从大到小），各区域的截取与解码在 pool 上并行执行
+    // pool 为空时使用共享池；不能在同一个池的任务内调用。crop 引用检测器内部缓冲区，下一次检测前有效
+    std::vector<BarcodeResult> DetectAll(const cv::Mat& frame, ImageProcessor::WorkStealingPool* pool = nullptr);
+
+    // 检测构造时加载的图像并显示结果，未找到条形码时抛出 std::runtime_error
     void DetectBarcode();
 
 private:
-    // 图像预处理，包括灰度转换和高斯滤波
+    friend class BarcodeBenchmark;  // 基准测试逐阶段计时
+
+    // 构建金字塔：第 i 层为原图按 2^i 面积降采样（尺寸向下取整），0 层引用原图；
+    // 只生成细化层到粗检测层之间的各层，并把各阶段的输入设为粗检测层
+    void BuildPyramid(const cv::Mat& frame);
+
+    // 图像预处理（当前检测图像），包括灰度转换和高斯滤波
     cv::Mat PreprocessImage();
 
     // 梯度增强与二值化，用于突出条形码区域
@@ -24,17 +66,61 @@ private:
     // 形态学操作，用于填充条形码间隙和去除噪声
     cv::Mat MorphologicalOperations(const cv::Mat& binary);
 
-    // 检测条形码区域，返回旋转矩形
-    cv::RotatedRect DetectBarcodeRegion(const cv::Mat& morph);
+    // 在 image（某一层或其中的区域）上做预处理、增强、二值化与形态学，结构元素放大 scale 倍，返回形态学结果
+    cv::Mat SegmentImage(const cv::Mat& image, int scale);
+
+    // 在细化层上对粗检测区域外扩后的范围重新分割，取最大轮廓，返回原图坐标的区域；
+    // 细化层即粗检测层或细化找不到轮廓时，返回粗检测区域换算到原图
+    cv::RotatedRect RefineRegion(const cv::RotatedRect& coarse_rect);
+
+    // 金字塔层间的坐标换算（像素中心对齐）
+    static cv::RotatedRect ScaleRect(const cv::RotatedRect& rect, int from_level, int to_level);
+
+    // 检测条形码区域（最大轮廓的旋转矩形），没有轮廓时返回 false
+    bool DetectBarcodeRegion(const cv::Mat& morph, cv::RotatedRect& rect);
+
+    // 连通域统计找出全部候选区域：先按像素数、外接框长宽比和填充率筛选，
+    // 只对通过的连通域提取轮廓求旋转矩形，结果按面积从大到小
+    void DetectBarcodeCandidates(const cv::Mat& morph, std::vector<cv::RotatedRect>& rects);
 
     // 在原图上绘制条形码框
     void DrawBarcodeBox(cv::Mat& display_img, const cv::RotatedRect& barcode_rect);
 
-    // 截取条形码区域，返回条形码图像
-    cv::Mat ExtractBarcodeRegion(const cv::RotatedRect& barcode_rect);
+    // 在细化层上截取条形码区域（原图坐标），返回条形码图像（细化层的子区域或 buffer），不修改检测器状态，可并行调用
+    cv::Mat ExtractBarcodeRegion(const cv::RotatedRect& source_rect, cv::Mat& buffer) const;
+
+    // 沿区域（原图坐标）轴线在原图上采样扫描线解码，可并行调用
+    BarcodeDecoder::ScanResult DecodeBarcodeRegion(const cv::RotatedRect& barcode_rect) const;
 
+    BarcodeParams params_;  // 检测参数
     cv::Mat src_;          // 原始图像
-    cv::Mat resized_src_;  // 调整大小后的图像
+    std::vector<cv::Mat> pyramid_;  // 图像金字塔（细化层之前的中间层为空）
+    int coarse_level_ = 0;          // 粗检测层
+    int refine_level_ = 0;          // 细化层
+    cv::Mat search_image_;          // 当前检测的图像（粗检测层或细化层中的候选区域）
+    int morph_size_ = 7;            // 当前检测图像的结构元素边长
+
+    // 各阶段的中间图像，帧间复用
+    cv::Mat gray_;
+    cv::Mat blurred_;
+    cv::Mat grad_x_;
+    cv::Mat grad_y_;
+    cv::Mat gradient_;
+    cv::Mat mean_filtered_;
+    cv::Mat binary_;
+    cv::Mat closed_;
+    cv::Mat eroded_;
+    cv::Mat dilated_;
+    cv::Mat barcode_img_;
+    std::vector<std::vector<cv::Point>> contours_;
+
+    // 多区域检测的中间结果，帧间复用
+    cv::Mat labels_;
+    cv::Mat stats_;
+    cv::Mat centroids_;
+    cv::Mat component_mask_;
+    std::vector<cv::RotatedRect> candidates_;
+    std::vector<cv::Mat> crops_;
 };
 
 #endif  // IMAGE_PROCESSING_BARCODE_DETECTOR_H_
\ No newline at end of file
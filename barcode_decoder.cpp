@@ -0,0 +1,402 @@
+#include "barcode_decoder.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <utility>
+
+namespace BarcodeDecoder {
+
+    namespace {
+
+        // 扫描线两端外延比例（相对区域长度），检测区域常常切掉静区和首尾几条线
+        constexpr float kScanMargin = 0.15f;
+        // 每个源图像像素的采样数，半像素步长配合亚像素边缘定位
+        constexpr float kSamplesPerPixel = 2.0f;
+        // 剖面最亮与最暗之差低于该值时不做解码
+        constexpr float kMinContrast = 20.0f;
+        // 静区至少为模块宽度的倍数（规范要求 EAN-13 为 11 / 7，Code 128 为 10，放宽以容忍贴边裁剪）
+        constexpr float kMinQuietModules = 3.0f;
+
+        // 条空宽度与模板的偏差阈值（相对总宽度的平均偏差 / 单个元素相对模块宽度的偏差）
+        constexpr float kEanMaxAverageVariance = 0.48f;
+        constexpr float kCode128MaxAverageVariance = 0.25f;
+        constexpr float kMaxIndividualVariance = 0.7f;
+
+        constexpr float kNoMatch = std::numeric_limits<float>::infinity();
+
+        // EAN-13 L 码（空条空条）的四个宽度，R 码宽度相同（条空条空），G 码为 L 码的倒序
+        constexpr int kEanDigitWidths[10][4] = {
+                {3, 2, 1, 1}, {2, 2, 2, 1}, {2, 1, 2, 2}, {1, 4, 1, 1}, {1, 1, 3, 2},
+                {1, 2, 3, 1}, {1, 1, 1, 4}, {1, 3, 1, 2}, {1, 2, 1, 3}, {3, 1, 1, 2}};
+        // 左侧六位的 L/G 组合（位 i 为 1 表示第 i 位为 G 码）决定首位数字
+        constexpr int kEanFirstDigitParity[10] = {0x00, 0x0B, 0x0D, 0x0E, 0x13, 0x19, 0x1C, 0x15, 0x16, 0x1A};
+
+        // Code 128 符号 0..105 的六个条空宽度（条空条空条空，共 11 个模块），106 为终止符（7 个元素，13 个模块）
+        constexpr int kCode128StartA = 103;
+        constexpr int kCode128StartC = 105;
+        constexpr int kCode128Stop = 106;
+        constexpr const char* kCode128Patterns[107] = {
+                "212222", "222122", "222221", "121223", "121322", "131222", "122213", "122312", "132212", "221213",
+                "221312", "231212", "112232", "122132", "122231", "113222", "123122", "123221", "223211", "221132",
+                "221231", "213212", "223112", "312131", "311222", "321122", "321221", "312212", "322112", "322211",
+                "212123", "212321", "232121", "111323", "131123", "131321", "112313", "132113", "132311", "211313",
+                "231113", "231311", "112133", "112331", "132131", "113123", "113321", "133121", "313121", "211331",
+                "231131", "213113", "213311", "213131", "311123", "311321", "331121", "312113", "312311", "332111",
+                "314111", "221411", "431111", "111224", "111422", "121124", "121421", "141122", "141221", "112214",
+                "112412", "122114", "122411", "142112", "142211", "241211", "221114", "413111", "241112", "134111",
+                "111242", "121142", "121241", "114212", "124112", "124211", "411212", "421112", "421211", "212141",
+                "214121", "412121", "111143", "111341", "131141", "114113", "114311", "411113", "411311", "113141",
+                "114131", "311141", "411131", "211412", "211214", "211232", "2331112"};
+
+        // 剖面二值化后的条空序列：widths[0] 为剖面起点到第一条边缘（起点一侧的静区）
+        struct Runs {
+            std::vector<float> widths;
+            bool first_dark = false;
+
+            bool Dark(size_t index) const { return (index % 2 == 0) == first_dark; }
+        };
+
+        // 与 count 个宽度的模板比较，返回平均偏差（相对总宽度），任一元素偏差过大时返回 kNoMatch
+        template <class Width>
+        float PatternVariance(const float* runs, const Width* pattern, int count, float max_average) {
+            float total = 0.0f;
+            int pattern_total = 0;
+            for (int i = 0; i < count; ++i) {
+                total += runs[i];
+                pattern_total += static_cast<int>(pattern[i]);
+            }
+            if (total <= 0.0f) return kNoMatch;
+
+            const float unit = total / static_cast<float>(pattern_total);
+            float variance = 0.0f;
+            for (int i = 0; i < count; ++i) {
+                const float deviation = std::abs(runs[i] - static_cast<float>(pattern[i]) * unit);
+                if (deviation > kMaxIndividualVariance * unit) return kNoMatch;
+                variance += deviation;
+            }
+            variance /= total;
+            return variance <= max_average ? variance : kNoMatch;
+        }
+
+        // 终止符只比较前 6 个元素（11 个模块），末尾的 2 模块条另行检查
+        float Code128Variance(const float* runs, int symbol) {
+            const char* pattern = kCode128Patterns[symbol];
+            int widths[6];
+            for (int i = 0; i < 6; ++i) widths[i] = pattern[i] - '0';
+            return PatternVariance(runs, widths, 6, kCode128MaxAverageVariance);
+        }
+
+        // 前后静区是否足够宽（剖面两端的条空宽度只是下界，同样参与判断）
+        bool HasQuietZones(const Runs& runs, size_t first, size_t last, float module) {
+            if (first == 0 || last + 1 >= runs.widths.size()) return false;
+            return runs.widths[first - 1] >= kMinQuietModules * module &&
+                   runs.widths[last + 1] >= kMinQuietModules * module;
+        }
+
+        // 起始 / 中间 / 终止保护符：每个元素约为一个模块
+        bool IsGuard(const float* runs, int count, float module) {
+            for (int i = 0; i < count; ++i) {
+                if (runs[i] < 0.4f * module || runs[i] > 1.8f * module) return false;
+            }
+            return true;
+        }
+
+        // 以 runs[first]（条）为起始保护符解码 EAN-13：3 + 24 + 5 + 24 + 3 = 59 个元素，共 95 个模块
+        bool DecodeEan13At(const Runs& runs, size_t first, std::string& text) {
+            constexpr int kElements = 59;
+            if (first + kElements > runs.widths.size()) return false;
+            const float* w = runs.widths.data() + first;
+
+            float total = 0.0f;
+            for (int i = 0; i < kElements; ++i) total += w[i];
+            const float module = total / 95.0f;
+            if (!HasQuietZones(runs, first, first + kElements - 1, module)) return false;
+            if (!IsGuard(w, 3, module) || !IsGuard(w + 27, 5, module) || !IsGuard(w + 56, 3, module)) return false;
+
+            int digits[13];
+            int parity = 0;
+            for (int d = 0; d < 12; ++d) {
+                const bool left = d < 6;
+                const float* element = w + (left ? 3 + 4 * d : 32 + 4 * (d - 6));
+                float best = kNoMatch;
+                for (int digit = 0; digit < 10; ++digit) {
+                    const int* widths = kEanDigitWidths[digit];
+                    const float variance = PatternVariance(element, widths, 4, kEanMaxAverageVariance);
+                    if (variance < best) {
+                        best = variance;
+                        digits[d + 1] = digit;
+                        if (left) parity &= ~(1 << (5 - d));
+                    }
+                    if (!left) continue;
+
+                    const int reversed[4] = {widths[3], widths[2], widths[1], widths[0]};
+                    const float g_variance = PatternVariance(element, reversed, 4, kEanMaxAverageVariance);
+                    if (g_variance < best) {
+                        best = g_variance;
+                        digits[d + 1] = digit;
+                        parity |= 1 << (5 - d);
+                    }
+                }
+                if (best == kNoMatch) return false;
+            }
+
+            const int* first_digit = std::find(kEanFirstDigitParity, kEanFirstDigitParity + 10, parity);
+            if (first_digit == kEanFirstDigitParity + 10) return false;
+            digits[0] = static_cast<int>(first_digit - kEanFirstDigitParity);
+
+            // 校验位：前 12 位奇数位权重 1、偶数位权重 3
+            int sum = 0;
+            for (int i = 0; i < 12; ++i) sum += digits[i] * (i % 2 == 0 ? 1 : 3);
+            if ((10 - sum % 10) % 10 != digits[12]) return false;
+
+            text.clear();
+            for (int digit : digits) text += static_cast<char>('0' + digit);
+            return true;
+        }
+
+        // 6 个元素匹配最好的符号（含终止符），没有可接受的匹配时返回 -1
+        int MatchCode128Symbol(const float* runs) {
+            int symbol = -1;
+            float best = kNoMatch;
+            for (int s = 0; s <= kCode128Stop; ++s) {
+                const float variance = Code128Variance(runs, s);
+                if (variance < best) {
+                    best = variance;
+                    symbol = s;
+                }
+            }
+            return symbol;
+        }
+
+        // 符号值按码集 A/B/C 转为文本，FNC1 在首位时为 GS1 标记（忽略），其它位置输出 GS（0x1D）
+        std::string Code128Text(int start, const std::vector<int>& values) {
+            std::string text;
+            int code_set = start - kCode128StartA;  // 0 = A, 1 = B, 2 = C
+            bool shift = false;
+            for (size_t i = 0; i < values.size(); ++i) {
+                const int value = values[i];
+                const int current = shift ? 1 - code_set : code_set;
+                shift = false;
+
+                if (value == 102) {
+                    if (i > 0) text += '\x1d';
+                    continue;
+                }
+                if (current == 2) {
+                    if (value < 100) {
+                        text += static_cast<char>('0' + value / 10);
+                        text += static_cast<char>('0' + value % 10);
+                    } else {
+                        code_set = value == 100 ? 1 : 0;
+                    }
+                    continue;
+                }
+                if (value < 96) {
+                    // A 码集 64..95 为控制字符，B 码集为 ASCII 32..127
+                    text += static_cast<char>(current == 0 && value >= 64 ? value - 64 : value + 32);
+                    continue;
+                }
+                switch (value) {
+                    case 98: shift = true; break;
+                    case 99: code_set = 2; break;
+                    case 100: if (current == 0) code_set = 1; break;  // B 码集中为 FNC4
+                    case 101: if (current == 1) code_set = 0; break;  // A 码集中为 FNC4
+                    default: break;                                   // FNC2 / FNC3
+                }
+            }
+            return text;
+        }
+
+        // 以 runs[first]（条）为起始符解码 Code 128，直到终止符
+        bool DecodeCode128At(const Runs& runs, size_t first, std::string& text) {
+            const size_t size = runs.widths.size();
+            if (first + 6 + 7 > size) return false;
+            const float* w = runs.widths.data();
+
+            int start = -1;
+            float best = kNoMatch;
+            for (int s = kCode128StartA; s <= kCode128StartC; ++s) {
+                const float variance = Code128Variance(w + first, s);
+                if (variance < best) {
+                    best = variance;
+                    start = s;
+                }
+            }
+            if (start < 0) return false;
+
+            float start_width = 0.0f;
+            for (int i = 0; i < 6; ++i) start_width += w[first + i];
+            const float module = start_width / 11.0f;
+            if (runs.widths[first - 1] < kMinQuietModules * module) return false;
+
+            std::vector<int> values;
+            size_t index = first + 6;
+            while (true) {
+                if (index + 6 > size) return false;
+                const int symbol = MatchCode128Symbol(w + index);
+                if (symbol == kCode128Stop) break;
+                if (symbol < 0 || symbol >= kCode128StartA) return false;
+                values.push_back(symbol);
+                index += 6;
+            }
+            // 终止符末尾的条宽 2 个模块
+            float stop_width = 0.0f;
+            for (int i = 0; i < 6; ++i) stop_width += w[index + i];
+            const float stop_module = stop_width / 11.0f;
+            if (index + 7 > size || std::abs(w[index + 6] - 2.0f * stop_module) > kMaxIndividualVariance * stop_module) {
+                return false;
+            }
+            if (values.size() < 2) return false;
+            if (!HasQuietZones(runs, first, index + 6, module)) return false;
+
+            // 校验符：起始符值 + 各数据符号值乘以位置（从 1 开始），模 103
+            const int check = values.back();
+            values.pop_back();
+            int sum = start;
+            for (size_t i = 0; i < values.size(); ++i) sum += static_cast<int>(i + 1) * values[i];
+            if (sum % 103 != check) return false;
+
+            text = Code128Text(start, values);
+            return true;
+        }
+
+        // 从每个条（暗）元素开始尝试，返回第一个完整通过校验的结果
+        ScanResult DecodeRuns(const Runs& runs) {
+            ScanResult result;
+            for (size_t i = 1; i < runs.widths.size(); ++i) {
+                if (!runs.Dark(i)) continue;
+                if (DecodeEan13At(runs, i, result.text)) {
+                    result.symbology = Symbology::kEan13;
+                } else if (DecodeCode128At(runs, i, result.text)) {
+                    result.symbology = Symbology::kCode128;
+                } else {
+                    continue;
+                }
+                result.decoded = true;
+                return result;
+            }
+            return result;
+        }
+
+        // 以最亮与最暗的中点为阈值，边缘位置在相邻采样间线性插值
+        bool Binarize(const std::vector<float>& profile, Runs& runs) {
+            if (profile.size() < 2) return false;
+            const auto [low, high] = std::minmax_element(profile.begin(), profile.end());
+            if (*high - *low < kMinContrast) return false;
+            const float threshold = (*low + *high) * 0.5f;
+
+            runs.widths.clear();
+            runs.first_dark = profile[0] < threshold;
+            float edge = 0.0f;
+            for (size_t i = 0; i + 1 < profile.size(); ++i) {
+                const bool dark = profile[i] < threshold;
+                if (dark == (profile[i + 1] < threshold)) continue;
+                const float position = static_cast<float>(i) + (threshold - profile[i]) / (profile[i + 1] - profile[i]);
+                runs.widths.push_back(position - edge);
+                edge = position;
+            }
+            runs.widths.push_back(static_cast<float>(profile.size() - 1) - edge);
+            return true;
+        }
+
+        // 双线性插值采样亮度（彩色图按 BT.601 权重转灰度），图像外按白色处理
+        float SampleIntensity(const cv::Mat& image, float x, float y) {
+            if (x < 0.0f || y < 0.0f || x > static_cast<float>(image.cols - 1) || y > static_cast<float>(image.rows - 1)) {
+                return 255.0f;
+            }
+            const int x0 = std::min(static_cast<int>(x), std::max(image.cols - 2, 0));
+            const int y0 = std::min(static_cast<int>(y), std::max(image.rows - 2, 0));
+            const int x1 = std::min(x0 + 1, image.cols - 1);
+            const int y1 = std::min(y0 + 1, image.rows - 1);
+            const float fx = x - static_cast<float>(x0);
+            const float fy = y - static_cast<float>(y0);
+
+            const int channels = image.channels();
+            auto at = [&](int row, int col) {
+                const uchar* p = image.ptr<uchar>(row) + static_cast<size_t>(col) * channels;
+                if (channels == 1) return static_cast<float>(p[0]);
+                return 0.114f * p[0] + 0.587f * p[1] + 0.299f * p[2];
+            };
+            const float top = at(y0, x0) + (at(y0, x1) - at(y0, x0)) * fx;
+            const float bottom = at(y1, x0) + (at(y1, x1) - at(y1, x0)) * fx;
+            return top + (bottom - top) * fy;
+        }
+
+        // 沿 from -> to 采样，每个采样点取垂直方向相距 1 像素的三点均值（沿条的方向平均以抑制噪声）
+        void SampleLine(const cv::Mat& image, cv::Point2f from, cv::Point2f to, std::vector<float>& profile) {
+            const cv::Point2f delta = to - from;
+            const float length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+            const int samples = std::max(2, static_cast<int>(std::ceil(length * kSamplesPerPixel)) + 1);
+            profile.resize(samples);
+            const cv::Point2f step = delta * (1.0f / static_cast<float>(samples - 1));
+            const cv::Point2f normal = length > 0.0f ? cv::Point2f(-delta.y, delta.x) * (1.0f / length) : cv::Point2f();
+            for (int i = 0; i < samples; ++i) {
+                const cv::Point2f point = from + step * static_cast<float>(i);
+                const cv::Point2f above = point - normal;
+                const cv::Point2f below = point + normal;
+                profile[i] = (SampleIntensity(image, above.x, above.y) + SampleIntensity(image, point.x, point.y) +
+                              SampleIntensity(image, below.x, below.y)) * (1.0f / 3.0f);
+            }
+        }
+
+    }  // namespace
+
+    const char* SymbologyName(Symbology symbology) {
+        switch (symbology) {
+            case Symbology::kEan13: return "EAN-13";
+            case Symbology::kCode128: return "Code 128";
+            default: return "";
+        }
+    }
+
+    ScanResult DecodeProfile(const std::vector<float>& profile) {
+        Runs runs;
+        if (!Binarize(profile, runs)) return ScanResult();
+
+        ScanResult result = DecodeRuns(runs);
+        if (result.decoded) return result;
+
+        // 反向扫描：元素序列倒序，末元素的颜色成为首元素的颜色
+        runs.first_dark = runs.Dark(runs.widths.size() - 1);
+        std::reverse(runs.widths.begin(), runs.widths.end());
+        return DecodeRuns(runs);
+    }
+
+    ScanResult DecodeRegion(const cv::Mat& image, const std::array<cv::Point2f, 4>& corners, int scanlines) {
+        TXMA_TRACE_SCOPE("BarcodeDecoder.DecodeRegion");
+        ScanResult result;
+        if (image.empty() || image.depth() != CV_8U || scanlines < 1) return result;
+
+        const cv::Point2f edges[2] = {corners[1] - corners[0], corners[2] - corners[1]};
+        const bool first_longer = edges[0].dot(edges[0]) >= edges[1].dot(edges[1]);
+        std::vector<float> profile;
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            // 扫描方向 along，扫描线在 across 方向上等距分布（不含两条边）
+            const bool use_first = (attempt == 0) == first_longer;
+            const cv::Point2f along = use_first ? edges[0] : edges[1];
+            const cv::Point2f across = use_first ? edges[1] : edges[0];
+
+            std::map<std::pair<Symbology, std::string>, int> votes;
+            for (int i = 0; i < scanlines; ++i) {
+                const float t = static_cast<float>(i + 1) / static_cast<float>(scanlines + 1);
+                const cv::Point2f base = corners[0] + across * t;
+                SampleLine(image, base - along * kScanMargin, base + along * (1.0f + kScanMargin), profile);
+                const ScanResult line = DecodeProfile(profile);
+                if (line.decoded) ++votes[{line.symbology, line.text}];
+            }
+            if (votes.empty()) continue;
+
+            const auto winner = std::max_element(votes.begin(), votes.end(),
+                                                 [](const auto& a, const auto& b) { return a.second < b.second; });
+            result.decoded = true;
+            result.symbology = winner->first.first;
+            result.text = winner->first.second;
+            result.confidence = static_cast<float>(winner->second) / static_cast<float>(scanlines);
+            return result;
+        }
+        return result;
+    }
+
+}  // namespace BarcodeDecoder
\ No newline at end of file
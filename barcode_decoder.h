@@ -0,0 +1,39 @@
+#ifndef BARCODE_DECODER_H
+#define BARCODE_DECODER_H
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <string>
+#include <vector>
+
+namespace BarcodeDecoder {
+
+    // 支持的一维码制
+    enum class Symbology {
+        kNone,
+        kEan13,
+        kCode128
+    };
+
+    // 码制名称（"EAN-13" / "Code 128"），kNone 返回空字符串
+    const char* SymbologyName(Symbology symbology);
+
+    // 解码结果
+    struct ScanResult {
+        bool decoded = false;                   // 是否有扫描线解码成功
+        Symbology symbology = Symbology::kNone;  // 码制
+        std::string text;                       // 解码内容（EAN-13 含校验位共 13 位数字）
+        float confidence = 0.0f;                // 与 text 一致的扫描线占全部扫描线的比例 [0, 1]
+    };
+
+    // 在 image（BGR 或灰度）中沿条形码区域的轴线采样 scanlines 条平行扫描线并解码，不做图像变换
+    // corners 为区域四个顶点（cv::RotatedRect::points 的顺序，image 坐标）；扫描线两端各外延区域长度的 15% 以包含静区
+    // 先沿长边方向扫描，全部失败时再沿短边方向扫描；多条扫描线按解码内容投票
+    ScanResult DecodeRegion(const cv::Mat& image, const std::array<cv::Point2f, 4>& corners, int scanlines);
+
+    // 解码一条灰度剖面（沿扫描方向的亮度采样），正反两个方向依次尝试 EAN-13 与 Code 128
+    ScanResult DecodeProfile(const std::vector<float>& profile);
+
+}  // namespace BarcodeDecoder
+
+#endif  // BARCODE_DECODER_H
\ No newline at end of file
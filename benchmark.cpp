@@ -0,0 +1,579 @@
+// 检测各阶段的基准测试：合成图像覆盖多种尺寸和圆/条码数量，仓库自带图像作为真实样本
+// 用法: txma_bench [数据目录]，数据目录中应包含 "circle image.png" 和 "barcode image.png"
+// 计时之前先检查各优化路径与 OpenCV 参考链路的输出一致，任一检查失败时以非零状态退出
+// 定义 TXMA_BENCH_LEGACY_CIRCLE_DETECTOR 时测试 circle_detector.h 中的旧版接口
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "barcode.h"
+#include "fast_morphology.h"
+#include "frame_pool.h"
+#include "fused_gradient.h"
+#include "fused_preprocess.h"
+#include "image_processor.h"
+#include "synthetic_images.h"
+
+#ifdef TXMA_BENCH_LEGACY_CIRCLE_DETECTOR
+#include "circle_detector.h"
+#else
+#include "circle_text.h"
+#endif
+
+// 访问 BarcodeDetector 的各个私有阶段
+class BarcodeBenchmark {
+public:
+    explicit BarcodeBenchmark(BarcodeDetector& detector) : detector_(detector) {}
+
+    cv::Mat Preprocess() { return detector_.PreprocessImage(); }
+    cv::Mat Enhance(const cv::Mat& processed) { return detector_.EnhanceAndBinarize(processed); }
+    cv::Mat Morph(const cv::Mat& binary) { return detector_.MorphologicalOperations(binary); }
+    bool Region(const cv::Mat& morph, cv::RotatedRect& rect) { return detector_.DetectBarcodeRegion(morph, rect); }
+    void Candidates(const cv::Mat& morph, std::vector<cv::RotatedRect>& rects) {
+        detector_.DetectBarcodeCandidates(morph, rects);
+    }
+    cv::RotatedRect Refine(const cv::RotatedRect& coarse_rect) { return detector_.RefineRegion(coarse_rect); }
+    void Pyramid(const cv::Mat& frame) { detector_.BuildPyramid(frame); }
+    cv::Mat Extract(const cv::RotatedRect& rect) { return detector_.ExtractBarcodeRegion(rect, detector_.barcode_img_); }
+    BarcodeDecoder::ScanResult Decode(const cv::RotatedRect& rect) { return detector_.DecodeBarcodeRegion(rect); }
+
+private:
+    BarcodeDetector& detector_;
+};
+
+namespace {
+
+    // 每个用例至少运行的时间和次数
+    constexpr double kMinSeconds = 0.5;
+    constexpr int kMinIterations = 5;
+
+    // 临时屏蔽标准输出，旧版检测器每帧都会打印圆心
+    class CoutSilencer {
+    public:
+        CoutSilencer() : previous_(std::cout.rdbuf(sink_.rdbuf())) {}
+        ~CoutSilencer() { std::cout.rdbuf(previous_); }
+
+    private:
+        std::ostringstream sink_;
+        std::streambuf* previous_;
+    };
+
+    // 运行 body 直到满足最少时间和次数，返回平均每次耗时（秒）
+    // steady_allocations 非空时输出预热之后 FramePool 的新分配次数，稳态下应为 0
+    double TimeIt(const std::function<void()>& body, uint64_t* steady_allocations = nullptr) {
+        body();  // 预热：分配缓冲区、加载代码页
+        const uint64_t allocations = ImageProcessor::FramePool::Shared().GetStats().allocations;
+        int iterations = 0;
+        const auto start = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        while (iterations < kMinIterations || elapsed < kMinSeconds) {
+            body();
+            ++iterations;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        if (steady_allocations) {
+            *steady_allocations = ImageProcessor::FramePool::Shared().GetStats().allocations - allocations;
+        }
+        return elapsed / iterations;
+    }
+
+    void PrintHeader() {
+        std::printf("%-42s %-11s %6s %10s %10s %10s\n", "case", "size", "count", "ms/frame", "frames/s", "MP/s");
+    }
+
+    // MP/s 按输入图像像素数计算
+    void Report(const std::string& name, cv::Size size, int count, double seconds) {
+        const double megapixels = static_cast<double>(size.area()) / 1e6;
+        std::printf("%-42s %5dx%-5d %6d %10.3f %10.1f %10.1f\n", name.c_str(), size.width, size.height,
+                    count, seconds * 1e3, 1.0 / seconds, megapixels / seconds);
+    }
+
+    // 召回率：真实圆（全分辨率坐标）按降采样倍数缩放后，3 像素内有检测结果即视为找到
+    void ReportRecall(const std::vector<cv::Vec3f>& truth, const std::vector<cv::Vec3f>& detected, double scale) {
+        if (truth.empty()) return;
+        size_t found = 0;
+        for (const auto& t : truth) {
+            for (const auto& d : detected) {
+                if (std::hypot(t[0] / scale - d[0], t[1] / scale - d[1]) < 3.0) {
+                    ++found;
+                    break;
+                }
+            }
+        }
+        std::printf("%-42s recall %zu/%zu, %zu detected\n", "", found, truth.size(), detected.size());
+    }
+
+    void ReportPoolAllocations(uint64_t allocations) {
+        std::printf("%-42s frame pool allocations after warm-up: %llu\n", "",
+                    static_cast<unsigned long long>(allocations));
+    }
+
+    // 一致性检查失败的次数，非零时 main 返回 1
+    int g_check_failures = 0;
+
+    void ReportCheck(const std::string& name, bool ok, const std::string& detail) {
+        std::printf("%-42s %-8s %s\n", name.c_str(), ok ? "ok" : "MISMATCH", detail.c_str());
+        if (!ok) ++g_check_failures;
+    }
+
+    // 均匀噪声（最坏情况）和合成圆图像（典型输入）
+    std::vector<cv::Mat> CheckImages(cv::Size size, int type, uint64_t seed) {
+        cv::Mat noise(size, type);
+        cv::RNG rng(seed);
+        rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+        cv::Mat circles = Synthetic::MakeCircleImage(size, 16, 80, seed);
+        if (type == CV_8UC1) cv::cvtColor(circles, circles, cv::COLOR_BGR2GRAY);
+        return {noise, circles};
+    }
+
+    // 整块平均（块和加面积的一半后整除，即 .5 向上舍入），ties 中标出块平均恰为 .5 的通道
+    cv::Mat BlockMean(const cv::Mat& bgr, int factor, cv::Mat& ties) {
+        const cv::Size out(bgr.cols / factor, bgr.rows / factor);
+        cv::Mat mean(out, CV_8UC3);
+        ties = cv::Mat(out, CV_8UC3);
+        const int area = factor * factor;
+        for (int y = 0; y < out.height; ++y) {
+            uchar* dst = mean.ptr<uchar>(y);
+            uchar* tie = ties.ptr<uchar>(y);
+            for (int x = 0; x < out.width; ++x, dst += 3, tie += 3) {
+                int sum[3] = {0, 0, 0};
+                for (int dy = 0; dy < factor; ++dy) {
+                    const uchar* src = bgr.ptr<uchar>(y * factor + dy) + static_cast<size_t>(x) * factor * 3;
+                    for (int i = 0; i < factor * 3; ++i) sum[i % 3] += src[i];
+                }
+                for (int c = 0; c < 3; ++c) {
+                    dst[c] = static_cast<uchar>((sum[c] + area / 2) / area);
+                    tie[c] = area % 2 == 0 && sum[c] % area == area / 2 ? 255 : 0;
+                }
+            }
+        }
+        return mean;
+    }
+
+    // 融合预处理与整块平均链路（BlockMean -> cvtColor -> medianBlur(3)）对比，灰度和彩色输出都要求逐像素一致；
+    // 同时确认与 OpenCV 链路（INTER_AREA）的差别只在块平均恰为 .5 处 INTER_AREA 舍入到偶数（见 fused_preprocess.h）
+    void CheckFusedPreprocess(uint64_t seed) {
+        for (const cv::Size size : {cv::Size(1000, 750), cv::Size(1003, 757), cv::Size(4024, 3036)}) {
+            for (const cv::Mat& image : CheckImages(size, CV_8UC3, seed)) {
+                for (const int factor : {1, 2, 3, 4, 5, 8, FusedPreprocess::kMaxFactor}) {
+                    const cv::Size out(size.width / factor, size.height / factor);
+                    cv::Mat ties, reference, fused, fused_color, resized;
+                    const cv::Mat mean = BlockMean(image, factor, ties);
+                    cv::cvtColor(mean, reference, cv::COLOR_BGR2GRAY);
+                    cv::medianBlur(reference, reference, 3);
+                    FusedPreprocess::DownscaleGrayMedian(image, factor, fused, &fused_color);
+
+                    const bool same_size = fused.size() == reference.size() && fused_color.size() == mean.size();
+                    const size_t gray_diff = same_size ? cv::countNonZero(fused != reference) : reference.total();
+                    const double color_diff = same_size ? cv::norm(fused_color, mean, cv::NORM_INF) : 255;
+
+                    cv::resize(image(cv::Rect(0, 0, out.width * factor, out.height * factor)), resized, out, 0, 0,
+                               cv::INTER_AREA);
+                    size_t area_diff = 0;
+                    size_t unexplained = 0;
+                    for (int y = 0; y < out.height; ++y) {
+                        const uchar* area = resized.ptr<uchar>(y);
+                        const uchar* exact = mean.ptr<uchar>(y);
+                        const uchar* tie = ties.ptr<uchar>(y);
+                        for (int i = 0; i < out.width * 3; ++i) {
+                            if (area[i] == exact[i]) continue;
+                            ++area_diff;
+                            if (!tie[i] || area[i] + 1 != exact[i] || area[i] % 2 != 0) ++unexplained;
+                        }
+                    }
+
+                    ReportCheck("check FusedPreprocess " + std::to_string(size.width) + "x" +
+                                std::to_string(size.height) + " /" + std::to_string(factor),
+                                gray_diff == 0 && color_diff == 0 && unexplained == 0,
+                                cv::format("%zu gray pixels differ, color max diff %.0f; INTER_AREA differs in %zu "
+                                           "channels, %zu not at .5 ties", gray_diff, color_diff, area_diff,
+                                           unexplained));
+                }
+            }
+        }
+    }
+
+    // 条码梯度融合内核与 BarcodeDetector::EnhanceAndBinarize 中的 OpenCV 链路对比，要求逐像素一致
+    // 包含宽度不是 SIMD 宽度整数倍的尺寸和 threshold 的两端（-1 时全部为 255，255 时全部为 0）
+    void CheckFusedGradient(uint64_t seed) {
+        for (const cv::Size size : {cv::Size(1200, 800), cv::Size(1003, 757), cv::Size(37, 5), cv::Size(3, 3)}) {
+            std::vector<cv::Mat> images = CheckImages(size, CV_8UC1, seed);
+            cv::Mat barcode;
+            cv::cvtColor(Synthetic::MakeBarcodeImage(size, 20, 12.0, seed), barcode, cv::COLOR_BGR2GRAY);
+            images.push_back(barcode);
+
+            size_t mismatched = 0;
+            int cases = 0;
+            for (const cv::Mat& gray : images) {
+                for (const int threshold : {-1, 0, 1, 45, 90, 200, 255}) {
+                    cv::Mat grad_x, grad_y, gradient, mean, reference, fused;
+                    cv::Sobel(gray, grad_x, CV_16S, 1, 0, 3, 1, 0, cv::BORDER_REFLECT_101);
+                    cv::Sobel(gray, grad_y, CV_16S, 0, 1, 3, 1, 0, cv::BORDER_REFLECT_101);
+                    cv::subtract(grad_x, grad_y, grad_x);
+                    cv::convertScaleAbs(grad_x, gradient);
+                    cv::blur(gradient, mean, cv::Size(3, 3));
+                    cv::threshold(mean, reference, threshold, 255, cv::THRESH_BINARY);
+                    FusedGradient::GradientThreshold(gray, fused, threshold);
+
+                    mismatched += fused.size() == reference.size() ? cv::countNonZero(fused != reference)
+                                                                   : reference.total();
+                    ++cases;
+                }
+            }
+            ReportCheck("check FusedGradient " + std::to_string(size.width) + "x" + std::to_string(size.height),
+                        mismatched == 0, cv::format("%zu pixels differ over %d cases", mismatched, cases));
+        }
+    }
+
+    // 流式形态学与 BarcodeDetector::MorphologicalOperations 中的 OpenCV 链路
+    // （闭运算 -> 腐蚀 -> 膨胀，size x size 矩形）对比，要求逐像素一致；
+    // 包含偶数尺寸（锚点不对称）、短窗口与转置的长窗口，以及比窗口还小的图像
+    void CheckFastMorphology(uint64_t seed) {
+        for (const cv::Size size : {cv::Size(1200, 800), cv::Size(1003, 757), cv::Size(37, 5), cv::Size(3, 3)}) {
+            // 二值输入：随机点（孤立像素多）、合成条码经梯度二值化（真实的条码形状）
+            std::vector<cv::Mat> images;
+            for (const cv::Mat& gray : CheckImages(size, CV_8UC1, seed)) {
+                cv::Mat binary;
+                cv::threshold(gray, binary, 160, 255, cv::THRESH_BINARY);
+                images.push_back(binary);
+            }
+            cv::Mat barcode, binary;
+            cv::cvtColor(Synthetic::MakeBarcodeImage(size, 20, 12.0, seed), barcode, cv::COLOR_BGR2GRAY);
+            FusedGradient::GradientThreshold(barcode, binary, 90);
+            images.push_back(binary);
+
+            size_t mismatched = 0;
+            int cases = 0;
+            for (const cv::Mat& image : images) {
+                for (const int morph_size : {1, 2, 3, 4, 7, 8, 15, 21, 32}) {
+                    const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(morph_size, morph_size));
+                    cv::Mat closed, eroded, reference, fast;
+                    cv::morphologyEx(image, closed, cv::MORPH_CLOSE, kernel);
+                    cv::morphologyEx(closed, eroded, cv::MORPH_ERODE, kernel);
+                    cv::morphologyEx(eroded, reference, cv::MORPH_DILATE, kernel);
+                    FastMorphology::CloseErodeDilate(image, fast, morph_size);
+
+                    mismatched += fast.size() == reference.size() ? cv::countNonZero(fast != reference)
+                                                                  : reference.total();
+                    ++cases;
+                }
+            }
+            ReportCheck("check FastMorphology " + std::to_string(size.width) + "x" + std::to_string(size.height),
+                        mismatched == 0, cv::format("%zu pixels differ over %d cases", mismatched, cases));
+        }
+    }
+
+#ifndef TXMA_BENCH_LEGACY_CIRCLE_DETECTOR
+    // 检测 + 可视化，Detector 为 BasicCircleDetector 的某个实例
+    template <class Detector>
+    void BenchDetectAndVisualize(const std::string& name, const cv::Mat& image, int count,
+                                 const std::vector<cv::Vec3f>& truth,
+                                 const CircleDetectionParams& params) {
+        Detector detector(params);
+        cv::Mat visualization;
+        uint64_t allocations = 0;
+        const double seconds = TimeIt([&] {
+            detector.detect(image);
+            detector.visualize_results(visualization);
+        }, &allocations);
+        Report(name, image.size(), count, seconds);
+        ReportRecall(truth, detector.get_detected_circles(), params.downscale);
+        ReportPoolAllocations(allocations);
+    }
+
+    // 分块检测与整幅图像一次检测对比：圆心距离 kTiledTolerance 内一一匹配，要求全部匹配且半径偏差在容差内
+    // min_dist 不小于真实圆的最近间距时，整幅检测会抑制相邻的圆而瓦片中不会（见 CircleDetectionParams::tiled），
+    // 这种差异是预期的，只报告不计为失败
+    void CheckTiledDetection(const std::string& label, const cv::Mat& image, const std::vector<cv::Vec3f>& truth,
+                             const CircleDetectionParams& full_params, const CircleDetectionParams& tiled_params) {
+        constexpr double kTiledTolerance = 2.0;
+        CircleDetector full_detector(full_params);
+        CircleDetector tiled_detector(tiled_params);
+        full_detector.detect(image);
+        tiled_detector.detect(image);
+        const std::vector<cv::Vec3f>& full = full_detector.get_detected_circles();
+        const std::vector<cv::Vec3f>& tiled = tiled_detector.get_detected_circles();
+
+        std::vector<char> used(tiled.size(), 0);
+        size_t matched = 0;
+        double max_center = 0.0, max_radius = 0.0;
+        for (const auto& a : full) {
+            size_t best = tiled.size();
+            double best_distance = kTiledTolerance;
+            for (size_t i = 0; i < tiled.size(); ++i) {
+                const double distance = std::hypot(a[0] - tiled[i][0], a[1] - tiled[i][1]);
+                if (!used[i] && distance <= best_distance) {
+                    best = i;
+                    best_distance = distance;
+                }
+            }
+            if (best == tiled.size()) continue;
+            used[best] = 1;
+            ++matched;
+            max_center = std::max(max_center, best_distance);
+            max_radius = std::max(max_radius, static_cast<double>(std::abs(a[2] - tiled[best][2])));
+        }
+
+        // 真实圆的最近间距（输入为全分辨率，full-res 变体不降采样，坐标直接可比）
+        double spacing = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < truth.size(); ++i) {
+            for (size_t j = i + 1; j < truth.size(); ++j) {
+                spacing = std::min<double>(spacing, std::hypot(truth[i][0] - truth[j][0], truth[i][1] - truth[j][1]));
+            }
+        }
+        const bool expected_to_match = full_params.min_dist < spacing;
+        const bool ok = matched == full.size() && matched == tiled.size() && max_radius <= kTiledTolerance;
+        const std::string detail = cv::format("%zu/%zu full, %zu/%zu tiled matched, max delta center %.2f radius %.2f",
+                                              matched, full.size(), matched, tiled.size(), max_center, max_radius);
+        if (expected_to_match) {
+            ReportCheck("check tiled vs full-res " + label, ok, detail);
+        } else {
+            std::printf("%-42s %-8s %s (min_dist %.0f >= circle spacing %.0f)\n",
+                        ("check tiled vs full-res " + label).c_str(), ok ? "ok" : "differs", detail.c_str(),
+                        full_params.min_dist, spacing);
+        }
+    }
+#endif
+
+    void BenchCircleDetector(const std::string& label, const cv::Mat& image, int count,
+                             const std::vector<cv::Vec3f>& truth = {}) {
+#ifdef TXMA_BENCH_LEGACY_CIRCLE_DETECTOR
+        LegacyCircleDetector detector;
+        double seconds;
+        uint64_t allocations = 0;
+        {
+            CoutSilencer silencer;
+            seconds = TimeIt([&] {
+                detector.set_image(image);
+                detector.detect_circles();
+                detector.draw_circles();
+            }, &allocations);
+        }
+        Report("LegacyCircleDetector::detect_circles+draw " + label, image.size(), count, seconds);
+        ReportRecall(truth, detector.get_circles(), 1.0);
+        ReportPoolAllocations(allocations);
+#else
+        struct Variant {
+            const char* name;
+            CircleDetector::DetectionParams params;
+        };
+        std::vector<Variant> variants(7);
+        variants[0].name = "";
+        // 跟踪模式：同一图像反复输入，稳态下只做窗口检测
+        variants[1].name = "tracking ";
+        variants[1].params.tracking = true;
+        // 融合预处理：降采样 + 灰度 + 中值滤波一次扫描
+        variants[2].name = "fused ";
+        variants[2].params.fused_preprocess = true;
+        // 窄半径带专用检测
+        variants[3].name = "band ";
+        variants[3].params.detector_type = 2;
+        // 全分辨率亚像素精化
+        variants[4].name = "subpixel ";
+        variants[4].params.subpixel_refine = true;
+        // 全分辨率检测（不降采样），整幅图像一次检测与分块并行检测对比
+        variants[5].name = "full-res ";
+        variants[5].params.downscale = 1;
+        variants[5].params.min_radius = 75;
+        variants[5].params.max_radius = 90;
+        variants[5].params.min_dist = 350.0;
+        variants[6] = variants[5];
+        variants[6].name = "full-res tiled ";
+        variants[6].params.tiled = true;
+
+        for (const auto& variant : variants) {
+            BenchDetectAndVisualize<CircleDetector>(
+                    std::string("CircleDetector::detect+visualize ") + variant.name + label,
+                    image, count, truth, variant.params);
+        }
+        CheckTiledDetection(label, image, truth, variants[5].params, variants[6].params);
+
+        // 编译期预处理策略（生产配置），与默认参数和融合预处理对比
+        BenchDetectAndVisualize<ProductionCircleDetector>(
+                "ProductionCircleDetector " + label, image, count, truth, variants[0].params);
+        BenchDetectAndVisualize<ProductionCircleDetector>(
+                "ProductionCircleDetector fused " + label, image, count, truth, variants[2].params);
+#endif
+    }
+
+#ifndef TXMA_BENCH_LEGACY_CIRCLE_DETECTOR
+    // 批量检测：逐张串行检测与 detect_batch 对比，MP/s 按整批像素计算
+    void BenchBatch(const std::string& label, const std::vector<cv::Mat>& images, int count) {
+        const cv::Size batch_size(images[0].cols, images[0].rows * static_cast<int>(images.size()));
+        CircleDetector detector;
+        Report("CircleDetector::detect x" + std::to_string(images.size()) + " " + label, batch_size, count,
+               TimeIt([&] {
+                   for (const auto& image : images) detector.detect(image);
+               }));
+
+        ImageProcessor::WorkStealingPool& pool = ImageProcessor::WorkStealingPool::Shared();
+        const auto steals = pool.GetStats().steals;
+        Report("CircleDetector::detect_batch x" + std::to_string(images.size()) + " " + label, batch_size, count,
+               TimeIt([&] { detector.detect_batch(images); }));
+        std::printf("%-42s %d slots, %llu steals\n", "", pool.Concurrency(),
+                    static_cast<unsigned long long>(pool.GetStats().steals - steals));
+    }
+#endif
+
+    void BenchDetectAndDraw(const std::string& label, const cv::Mat& image, int count) {
+        ImageProcessor::ImageProcessor processor("");
+        uint64_t allocations = 0;
+        const double seconds = TimeIt([&] { processor.DetectAndDrawCircles(image); }, &allocations);
+        Report("ImageProcessor::DetectAndDrawCircles " + label, image.size(), count, seconds);
+        ReportPoolAllocations(allocations);
+    }
+
+    void BenchBarcode(const std::string& label, const std::string& image_path, cv::Size size, int count) {
+        BarcodeDetector detector(image_path);
+        BarcodeBenchmark stages(detector);
+
+        const cv::Mat processed = stages.Preprocess();
+        const cv::Mat binary = stages.Enhance(processed);
+        const cv::Mat morph = stages.Morph(binary);
+        cv::RotatedRect rect;
+        if (!stages.Region(morph, rect)) {
+            std::printf("%-42s skipped: no contours\n", ("BarcodeDetector " + label).c_str());
+            return;
+        }
+
+        Report("BarcodeDetector::PreprocessImage " + label, size, count,
+               TimeIt([&] { stages.Preprocess(); }));
+        Report("BarcodeDetector::EnhanceAndBinarize " + label, size, count,
+               TimeIt([&] { stages.Enhance(processed); }));
+        {
+            // 逐步调用 OpenCV 的原始链路，与默认的融合内核对比
+            BarcodeParams reference_params;
+            reference_params.fused_gradient = false;
+            BarcodeDetector reference(image_path, reference_params);
+            BarcodeBenchmark reference_stages(reference);
+            Report("BarcodeDetector::EnhanceAndBinarize opencv " + label, size, count,
+                   TimeIt([&] { reference_stages.Enhance(processed); }));
+        }
+        Report("BarcodeDetector::MorphologicalOperations " + label, size, count,
+               TimeIt([&] { stages.Morph(binary); }));
+        {
+            BarcodeParams reference_params;
+            reference_params.fast_morphology = false;
+            BarcodeDetector reference(image_path, reference_params);
+            BarcodeBenchmark reference_stages(reference);
+            Report("BarcodeDetector::MorphologicalOperations opencv " + label, size, count,
+                   TimeIt([&] { reference_stages.Morph(binary); }));
+        }
+        Report("BarcodeDetector::DetectBarcodeRegion " + label, size, count,
+               TimeIt([&] { stages.Region(morph, rect); }));
+        std::vector<cv::RotatedRect> candidates;
+        Report("BarcodeDetector::DetectBarcodeCandidates " + label, size, count,
+               TimeIt([&] { stages.Candidates(morph, candidates); }));
+
+        // 细化会覆盖上面各阶段的中间缓冲区，放在粗检测层各阶段之后
+        const cv::RotatedRect refined = stages.Refine(rect);
+        Report("BarcodeDetector::RefineRegion " + label, size, count,
+               TimeIt([&] { stages.Refine(rect); }));
+        Report("BarcodeDetector::ExtractBarcodeRegion " + label, size, count,
+               TimeIt([&] { stages.Extract(refined); }));
+        Report("BarcodeDetector::DecodeBarcodeRegion " + label, size, count,
+               TimeIt([&] { stages.Decode(refined); }));
+        Report("BarcodeDetector constructor (imread+pyramid) " + label, size, count,
+               TimeIt([&] { BarcodeDetector reload(image_path); }));
+
+        // 长期持有的检测器逐帧检测（金字塔、细化与解码），缓冲区帧间复用
+        const cv::Mat frame = cv::imread(image_path);
+        Report("BarcodeDetector::BuildPyramid " + label, size, count,
+               TimeIt([&] { stages.Pyramid(frame); }));
+        BarcodeDetector streaming;
+        Report("BarcodeDetector::Detect (streaming) " + label, size, count,
+               TimeIt([&] { streaming.Detect(frame); }));
+        Report("BarcodeDetector::DetectAll (streaming) " + label, size, count,
+               TimeIt([&] { streaming.DetectAll(frame); }));
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::string data_dir = argc > 1 ? std::string(argv[1]) + "/" : "";
+    const uint64_t seed = 20240601;
+
+    CheckFusedPreprocess(seed);
+    CheckFusedGradient(seed);
+    CheckFastMorphology(seed);
+    std::printf("\n");
+
+    PrintHeader();
+
+    // 圆检测：检测器输入为全分辨率图像（内部 1/5 降采样），半径 80 对应降采样后的 16
+#ifdef TXMA_BENCH_LEGACY_CIRCLE_DETECTOR
+    const int detector_radius = 36;  // 旧版检测器在原图上检测 30~42 的半径
+#else
+    const int detector_radius = 80;
+#endif
+    for (const cv::Size size : {cv::Size(1000, 750), cv::Size(2000, 1500), cv::Size(4000, 3000)}) {
+        for (const int count : {4, 16, 64}) {
+            std::vector<cv::Vec3f> truth;
+            const cv::Mat image = Synthetic::MakeCircleImage(size, count, detector_radius, seed, &truth);
+            BenchCircleDetector("synthetic", image, count, truth);
+        }
+    }
+
+#ifndef TXMA_BENCH_LEGACY_CIRCLE_DETECTOR
+    // 批量检测：圆数量不同的图像混在一起，各张耗时不均
+    {
+        std::vector<cv::Mat> batch;
+        for (int i = 0; i < 16; ++i) {
+            batch.push_back(Synthetic::MakeCircleImage(cv::Size(2000, 1500), 4 << (i % 3), detector_radius, seed + i));
+        }
+        BenchBatch("synthetic", batch, 0);
+    }
+#endif
+
+    // DetectAndDrawCircles 的输入已是降采样后的图像
+    for (const cv::Size size : {cv::Size(400, 300), cv::Size(800, 600)}) {
+        for (const int count : {4, 16, 64}) {
+            const cv::Mat image = Synthetic::MakeCircleImage(size, count, 16, seed);
+            BenchDetectAndDraw("synthetic", image, count);
+        }
+    }
+
+    // 条码检测：合成图像写入临时文件，因为检测器只接受路径
+    for (const cv::Size size : {cv::Size(1200, 800), cv::Size(4000, 3000)}) {
+        for (const int bars : {20, 60}) {
+            const std::string path = "txma_bench_barcode.png";
+            cv::imwrite(path, Synthetic::MakeBarcodeImage(size, bars, 12.0, seed));
+            BenchBarcode("synthetic", path, size, bars);
+            std::remove(path.c_str());
+        }
+    }
+
+    // 真实样本
+    const cv::Mat circle_real = cv::imread(data_dir + "circle image.png");
+    if (!circle_real.empty()) {
+        BenchCircleDetector("circle image.png", circle_real, 0);
+        cv::Mat resized;
+        cv::resize(circle_real, resized, cv::Size(circle_real.cols / 5, circle_real.rows / 5));
+        BenchDetectAndDraw("circle image.png", resized, 0);
+    } else {
+        std::printf("circle image.png not found in '%s', skipped\n", data_dir.c_str());
+    }
+
+    const std::string barcode_path = data_dir + "barcode image.png";
+    const cv::Mat barcode_real = cv::imread(barcode_path);
+    if (!barcode_real.empty()) {
+        BenchBarcode("barcode image.png", barcode_path, barcode_real.size(), 0);
+    } else {
+        std::printf("barcode image.png not found in '%s', skipped\n", data_dir.c_str());
+    }
+
+    if (g_check_failures > 0) {
+        std::printf("%d consistency check(s) failed\n", g_check_failures);
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace ImageProcessor {
+
+// 有界无锁多生产者多消费者队列（环形缓冲区 + 每个槽位的序号）
+// 容量向上取整为 2 的幂，队列满时 TryPush 返回 false，由调用方决定等待策略
+    template <typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t capacity)
+                : capacity_(RoundUpPowerOfTwo(capacity)),
+                  mask_(capacity_ - 1),
+                  cells_(std::make_unique<Cell[]>(capacity_)) {
+            for (size_t i = 0; i < capacity_; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        // 入队，队列满时返回 false 且不修改 value
+        bool TryPush(T& value) {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = cells_[pos & mask_];
+                const size_t seq = cell.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.value = std::move(value);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // 出队，队列空时返回 false
+        bool TryPop(T& value) {
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = cells_[pos & mask_];
+                const size_t seq = cell.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        value = std::move(cell.value);
+                        cell.value = T();
+                        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // 当前队列深度（近似值，仅用于监控）
+        size_t Size() const {
+            const size_t enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+            const size_t dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        bool Empty() const { return Size() == 0; }
+
+        size_t Capacity() const { return capacity_; }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence{0};
+            T value{};
+        };
+
+        static size_t RoundUpPowerOfTwo(size_t n) {
+            size_t capacity = 2;
+            while (capacity < n) capacity <<= 1;
+            return capacity;
+        }
+
+        const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+        alignas(64) std::atomic<size_t> enqueue_pos_{0};  // 生产者位置，独占缓存行
+        alignas(64) std::atomic<size_t> dequeue_pos_{0};  // 消费者位置，独占缓存行
+    };
+
+}  // namespace ImageProcessor
+
+#endif  // BOUNDED_QUEUE_H
\ No newline at end of file
@@ -2,15 +2,18 @@
 #define IMAGE_PROCESSING_CIRCLEDETECTOR_H_
 
 #include <opencv2/opencv.hpp>
+#include <memory>
 #include <vector>
+#include "circle_text.h"
 
-// 圆检测器类，用于检测图像中的圆并绘制结果
-class CircleDetector {
+// 旧版圆检测接口：在原图上检测（不降采样），参数固定，绘制所有圆心两两之间的距离
+// 检测由 circle_text.h 中的 CircleDetector 完成，两者可以链接进同一个程序
+class LegacyCircleDetector {
 public:
     // 构造函数
-    CircleDetector();
+    LegacyCircleDetector();
 
-    // 设置待处理的图像
+    // 设置待处理的图像，只保留引用不复制，检测和绘制完成前调用方不得修改图像
     void set_image(const cv::Mat& image);
 
     // 设置滤波类型
@@ -20,22 +23,20 @@ public:
     // 检测图像中的圆
     bool detect_circles();
 
-    // 获取检测到的圆
-    std::vector<cv::Vec3f> get_circles() const;
+    // 获取检测到的圆，引用在下一次 set_image 前有效
+    const std::vector<cv::Vec3f>& get_circles() const;
 
-    // 绘制检测到的圆并返回结果图像
+    // 绘制检测到的圆并返回结果图像，缓冲区取自 ImageProcessor::FramePool
     cv::Mat draw_circles();
 
-private:
-    // 图像预处理，包括灰度转换和滤波
-    void preprocess_image();
+    // 旧版滤波类型对应的检测参数
+    static CircleDetector::DetectionParams MakeParams(int filter_type);
 
+private:
     cv::Mat src_;                // 原始图像
-    cv::Mat processed_image_;    // 预处理后的图像
-    std::vector<cv::Vec3f> circles_;  // 检测到的圆
-    std::vector<cv::Point> centers_;  // 圆心坐标
+    std::unique_ptr<CircleDetector> detector_;  // 实际执行检测的检测器
+    bool detected_ = false;      // src_ 是否已检测
     cv::Mat result_image_;       // 绘制结果图像
-    int filter_type_;            // 滤波类型
 };
 
 #endif  // IMAGE_PROCESSING_CIRCLEDETECTOR_H_
\ No newline at end of file
@@ -1,77 +1,214 @@
 #include <cmath>
 #include "circle_text.h"
+#include "frame_pool.h"
+#include "image_ingest.h"
+#include "trace.h"
 
-CircleDetector::CircleDetector(const DetectionParams& params)
-        : detect_params_(params) {}
+void DetectCirclesWithParams(const cv::Mat& gray, const CircleDetectionParams& params,
+                             std::vector<cv::Vec3f>& circles) {
+    if (params.detector_type == 2 && params.max_radius - params.min_radius < BandCircleDetector::kMaxRadiusBand) {
+        BandCircleDetector::DetectCircles(gray, circles, params.dp, params.min_dist, params.param1, params.param2,
+                                          params.min_radius, params.max_radius);
+        return;
+    }
+
+    TXMA_TRACE_SCOPE("CircleDetector.HoughCircles");
+    cv::HoughCircles(gray, circles, cv::HOUGH_GRADIENT, params.dp, params.min_dist, params.param1, params.param2,
+                     params.min_radius, params.max_radius);
+}
+
+template <class Preprocess>
+BasicCircleDetector<Preprocess>::BasicCircleDetector() : BasicCircleDetector(DetectionParams()) {}
 
-void CircleDetector::set_visualization_params(const VisualizationParams& params) {
+template <class Preprocess>
+BasicCircleDetector<Preprocess>::BasicCircleDetector(const DetectionParams& params)
+        : detect_params_(params),
+          preprocess_(params),
+          tracker_(CircleTracker::Params{params.full_search_interval, params.tracking_margin}) {}
+
+template <class Preprocess>
+void BasicCircleDetector<Preprocess>::set_visualization_params(const VisualizationParams& params) {
     visual_params_ = params;
 }
 
-bool CircleDetector::detect(const cv::Mat& input_image) {
+template <class Preprocess>
+bool BasicCircleDetector<Preprocess>::detect(const cv::Mat& input_image) {
     // 图像预处理
     preprocess_image(input_image);
 
-    // 执行霍夫圆检测
-    cv::HoughCircles(processed_image_, circles_, cv::HOUGH_GRADIENT,
-                     detect_params_.dp, detect_params_.min_dist,
-                     detect_params_.param1, detect_params_.param2,
-                     detect_params_.min_radius, detect_params_.max_radius);
+    return detect_circles(input_image);
+}
+
+template <class Preprocess>
+bool BasicCircleDetector<Preprocess>::detect(const std::string& image_path) {
+    // 边解码边降采样，无需可视化时直接输出灰度图；需要精化时同一次解码保留全分辨率灰度图
+    cv::Mat full_gray;
+    cv::Mat* full_output = detect_params_.subpixel_refine ? &full_gray : nullptr;
+    if (detect_params_.keep_color) {
+        resized_image_ = ImageIngest::ReadDownscaled(image_path, preprocess_.downscale(), false, full_output);
+        if (!resized_image_.empty()) {
+            cv::cvtColor(resized_image_, processed_image_, cv::COLOR_BGR2GRAY);
+        }
+    } else {
+        resized_image_.release();
+        processed_image_ = ImageIngest::ReadDownscaled(image_path, preprocess_.downscale(), true, full_output);
+    }
+
+    if (processed_image_.empty()) {
+        circles_.clear();
+        distances_.clear();
+        return false;
+    }
+
+    apply_blur();
+    return detect_circles(full_gray);
+}
+
+template <class Preprocess>
+std::vector<CircleBatchResult> BasicCircleDetector<Preprocess>::detect_batch(
+        std::span<const cv::Mat> images, ImageProcessor::WorkStealingPool* pool) const {
+    return detect_batch_impl(images, pool);
+}
+
+template <class Preprocess>
+std::vector<CircleBatchResult> BasicCircleDetector<Preprocess>::detect_batch(
+        std::span<const std::string> image_paths, ImageProcessor::WorkStealingPool* pool) const {
+    return detect_batch_impl(image_paths, pool);
+}
+
+template <class Preprocess>
+template <class Input>
+std::vector<CircleBatchResult> BasicCircleDetector<Preprocess>::detect_batch_impl(
+        std::span<const Input> inputs, ImageProcessor::WorkStealingPool* pool) const {
+    TXMA_TRACE_SCOPE("CircleDetector.detect_batch");
+    if (!pool) pool = &ImageProcessor::WorkStealingPool::Shared();
+
+    // 每个槽位的检测器在第一次用到时创建，同一槽位不会被两个线程同时使用
+    DetectionParams params = detect_params_;
+    params.tracking = false;
+    params.tiled = false;  // 图像已在池上并行，分块会嵌套调用 ParallelFor
+    std::vector<std::unique_ptr<BasicCircleDetector>> detectors(pool->Concurrency());
+
+    std::vector<BatchResult> results(inputs.size());
+    pool->ParallelFor(inputs.size(), [&](size_t index, int slot) {
+        std::unique_ptr<BasicCircleDetector>& detector = detectors[slot];
+        if (!detector) detector = std::make_unique<BasicCircleDetector>(params);
+
+        BatchResult& result = results[index];
+        result.found = detector->detect(inputs[index]);
+        if (result.found) {
+            result.circles = detector->circles_;
+            result.distances = detector->distances_;
+        }
+    });
+    return results;
+}
+
+template <class Preprocess>
+bool BasicCircleDetector<Preprocess>::detect_circles(const cv::Mat& full_image) {
+    // 执行霍夫圆检测，跟踪模式下优先只搜索上一帧圆附近的窗口
+    if (detect_params_.tracking) {
+        tracker_.Detect(processed_image_, detect_params_.max_radius,
+                        [this](const cv::Mat& gray, std::vector<cv::Vec3f>& circles) {
+                            hough_circles(gray, circles);
+                        },
+                        circles_);
+    } else {
+        hough_circles(processed_image_, circles_);
+    }
+
+    // 间距按下标引用 circles_，圆被替换后必须重新计算，未检测到圆时同样清空，避免沿用上一帧的下标
+    if (circles_.empty()) {
+        distances_.clear();
+        return false;
+    }
 
-    if (circles_.empty()) return false;
+    if (detect_params_.subpixel_refine && !full_image.empty()) {
+        SubpixelRefine::RefineCircles(full_image, preprocess_.downscale(), circles_);
+    }
 
     // 计算圆心间距
     calculate_distances();
     return true;
 }
 
-void CircleDetector::preprocess_image(const cv::Mat& input) {
-    // 尺寸调整
-    cv::resize(input, resized_image_, cv::Size(input.cols / 5, input.rows / 5));
-
-    // 灰度转换
-    cv::cvtColor(resized_image_, processed_image_, cv::COLOR_BGR2GRAY);
-
-    // 噪声去除
-    switch (detect_params_.blur_type) {
-        case 1:
-            cv::medianBlur(processed_image_, processed_image_, detect_params_.blur_size);
-            break;
-        case 2:
-            cv::GaussianBlur(processed_image_, processed_image_,
-                             cv::Size(detect_params_.blur_size, detect_params_.blur_size), 2);
-            break;
-        case 3:
-            cv::blur(processed_image_, processed_image_,
-                     cv::Size(detect_params_.blur_size, detect_params_.blur_size));
-            break;
+template <class Preprocess>
+void BasicCircleDetector<Preprocess>::hough_circles(const cv::Mat& gray, std::vector<cv::Vec3f>& circles) const {
+    if (detect_params_.tiled) {
+        const TiledCircleDetection::Params tiling{detect_params_.tile_size, detect_params_.max_radius,
+                                                  detect_params_.min_dist};
+        TiledCircleDetection::Detect(gray, tiling,
+                                     [this](const cv::Mat& tile, std::vector<cv::Vec3f>& found) {
+                                         hough_circles_single(tile, found);
+                                     },
+                                     ImageProcessor::WorkStealingPool::Shared(), circles);
+        return;
     }
+    hough_circles_single(gray, circles);
 }
 
-void CircleDetector::calculate_distances() {
-    connections_.clear();
-    distances_.clear();
+template <class Preprocess>
+void BasicCircleDetector<Preprocess>::hough_circles_single(const cv::Mat& gray, std::vector<cv::Vec3f>& circles) const {
+    DetectCirclesWithParams(gray, detect_params_, circles);
+}
 
-    std::vector<cv::Point> centers;
-    for (const auto& circle : circles_) {
-        centers.emplace_back(cvRound(circle[0]), cvRound(circle[1]));
+template <class Preprocess>
+void BasicCircleDetector<Preprocess>::preprocess_image(const cv::Mat& input) {
+    // 融合路径：不生成全尺寸中间图像，输出写入复用的缓冲区；倍数超出融合内核的范围时走 OpenCV 链路
+    if (preprocess_.blur_type() == CirclePreprocess::kMedianBlur && preprocess_.blur_size() == 3 &&
+        preprocess_.downscale() <= FusedPreprocess::kMaxFactor && detect_params_.fused_preprocess &&
+        input.type() == CV_8UC3) {
+        FusedPreprocess::DownscaleGrayMedian(input, preprocess_.downscale(), processed_image_,
+                                             detect_params_.keep_color ? &resized_image_ : nullptr);
+        if (!detect_params_.keep_color) resized_image_.release();
+        return;
     }
 
-    for (size_t i = 0; i < centers.size(); ++i) {
-        for (size_t j = i + 1; j < centers.size(); ++j) {
-            const auto dx = centers[j].x - centers[i].x;
-            const auto dy = centers[j].y - centers[i].y;
-            const double dist = std::sqrt(dx * dx + dy * dy);
+    // 尺寸调整，不降采样时直接引用输入
+    // 与 ImageIngest::ReadDownscaled、融合路径相同：裁掉不足一个块的边缘后整块平均，同一图像从各入口得到相同的圆
+    if (preprocess_.downscale() == 1) {
+        resized_image_ = input;
+    } else {
+        TXMA_TRACE_SCOPE("CircleDetector.resize");
+        const int factor = preprocess_.downscale();
+        const cv::Size size(input.cols / factor, input.rows / factor);
+        cv::resize(input(cv::Rect(0, 0, size.width * factor, size.height * factor)), resized_image_, size,
+                   0, 0, cv::INTER_AREA);
+    }
 
-            connections_.emplace_back(centers[i], centers[j]);
-            distances_.push_back(dist);
-        }
+    // 灰度转换
+    {
+        TXMA_TRACE_SCOPE("CircleDetector.cvtColor");
+        cv::cvtColor(resized_image_, processed_image_, cv::COLOR_BGR2GRAY);
     }
+
+    apply_blur();
 }
 
-void CircleDetector::visualize_results(cv::Mat& output_image) const {
-    // 使用尺寸调整后的彩色图像作为背景
-    output_image = resized_image_.clone();
+template <class Preprocess>
+void BasicCircleDetector<Preprocess>::apply_blur() {
+    TXMA_TRACE_SCOPE("CircleDetector.blur");
+    // 噪声去除
+    CirclePreprocess::ApplyBlur(preprocess_, processed_image_);
+}
+
+template <class Preprocess>
+void BasicCircleDetector<Preprocess>::calculate_distances() {
+    distances_ = ImageProcessor::MeasurePitches(circles_, detect_params_.pitch);
+}
+
+template <class Preprocess>
+void BasicCircleDetector<Preprocess>::visualize_results(cv::Mat& output_image) const {
+    TXMA_TRACE_SCOPE("CircleDetector.visualize_results");
+    // 使用尺寸调整后的彩色图像作为背景，灰度读入时转换为三通道
+    // output_image 尺寸不符时从 FramePool 取缓冲区，连续帧传入同一个 output_image 时不再分配
+    const cv::Size size = resized_image_.empty() ? processed_image_.size() : resized_image_.size();
+    ImageProcessor::FramePool::Shared().Ensure(output_image, size, CV_8UC3);
+    if (resized_image_.empty()) {
+        cv::cvtColor(processed_image_, output_image, cv::COLOR_GRAY2BGR);
+    } else {
+        resized_image_.copyTo(output_image);
+    }
 
     // 绘制检测结果
     for (const auto& circle : circles_) {
@@ -97,8 +234,9 @@ void CircleDetector::visualize_results(cv::Mat& output_image) const {
 
     // 绘制连接线
     if (visual_params_.draw_connections) {
-        for (size_t i = 0; i < connections_.size(); ++i) {
-            const auto& [pt1, pt2] = connections_[i];
+        for (const auto& distance : distances_) {
+            const cv::Point pt1(cvRound(circles_[distance.first][0]), cvRound(circles_[distance.first][1]));
+            const cv::Point pt2(cvRound(circles_[distance.second][0]), cvRound(circles_[distance.second][1]));
 
             // 绘制连线
             cv::line(output_image, pt1, pt2,
@@ -106,13 +244,38 @@ void CircleDetector::visualize_results(cv::Mat& output_image) const {
 
             // 显示距离
             const cv::Point mid_pt = (pt1 + pt2) / 2;
-            const std::string dist_text = cv::format("%.2f px", distances_[i]);
+            const std::string dist_text = cv::format("%.2f px", distance.distance);
             cv::putText(output_image, dist_text, mid_pt + cv::Point(0, -10),
                         cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 255), 2);
         }
     }
 }
 
-const std::vector<cv::Vec3f>& CircleDetector::get_detected_circles() const {
+template <class Preprocess>
+const std::vector<cv::Vec3f>& BasicCircleDetector<Preprocess>::get_detected_circles() const {
     return circles_;
-}
\ No newline at end of file
+}
+
+template <class Preprocess>
+const std::vector<ImageProcessor::CircleDistance>& BasicCircleDetector<Preprocess>::get_distances() const {
+    return distances_;
+}
+
+template <class Preprocess>
+void BasicCircleDetector<Preprocess>::compute_distance_matrix(std::vector<float>& matrix) const {
+    ImageProcessor::DistanceMatrix(circles_, matrix);
+}
+
+template <class Preprocess>
+void BasicCircleDetector<Preprocess>::reset_tracking() {
+    tracker_.Reset();
+}
+
+template <class Preprocess>
+CircleTracker::Stats BasicCircleDetector<Preprocess>::get_tracking_stats() const {
+    return tracker_.GetStats();
+}
+
+// 显式实例化，新增预处理策略时在此补充
+template class BasicCircleDetector<CirclePreprocess::RuntimePreprocess>;
+template class BasicCircleDetector<CirclePreprocess::FixedPreprocess<CirclePreprocess::kMedianBlur, 3, 5>>;
\ No newline at end of file
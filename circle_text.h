@@ -4,33 +4,139 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <memory>
+#include <span>
+#include <string>
+#include "band_circle_detector.h"
+#include "circle_tracker.h"
+#include "fused_preprocess.h"
+#include "pitch_measurement.h"
+#include "subpixel_refine.h"
+#include "tiled_circle_detection.h"
+#include "work_stealing_pool.h"
 
-// 圆检测器类，用于检测图像中的圆并绘制结果
-class CircleDetector {
-public:
-    // 检测参数结构体
-    struct DetectionParams {
-        int blur_type = 1;               // 1: 中值滤波, 2: 高斯滤波, 3: 均值滤波
-        int blur_size = 3;               // 滤波核尺寸
-        double dp = 2.0;                 // 累加器分辨率
-        double min_dist = 70.0;          // 圆心最小间距
-        double param1 = 150.0;           // Canny边缘检测阈值
-        double param2 = 40.0;            // 累加器阈值
-        int min_radius = 15;             // 最小圆半径
-        int max_radius = 18;             // 最大圆半径
+// 检测参数结构体
+// 使用编译期预处理策略（FixedPreprocess）时 blur_type / blur_size / downscale 由策略决定，此处的值被忽略
+struct CircleDetectionParams {
+    int blur_type = 1;               // 0: 无滤波, 1: 中值滤波, 2: 高斯滤波, 3: 均值滤波
+    int blur_size = 3;               // 滤波核尺寸
+    double dp = 2.0;                 // 累加器分辨率
+    double min_dist = 70.0;          // 圆心最小间距
+    double param1 = 150.0;           // Canny边缘检测阈值
+    double param2 = 40.0;            // 累加器阈值
+    int min_radius = 15;             // 最小圆半径
+    int max_radius = 18;             // 最大圆半径
+    bool subpixel_refine = false;    // 在全分辨率图像上将圆心和半径精化到亚像素
+    ImageProcessor::PitchOptions pitch;  // 圆心距离测量方式，默认只测阵列相邻的孔距
+    int detector_type = 1;           // 1: cv::HoughCircles, 2: 窄半径带专用检测（带宽超过 16 时退回 1）
+    int downscale = 5;               // 降采样倍数
+    bool keep_color = true;          // 是否保留彩色缩放图用于可视化，关闭时直接读入灰度图
+    bool fused_preprocess = false;   // 降采样/灰度/中值滤波一次扫描完成（块平均降采样，仅 3x3 中值滤波且降采样倍数不超过 16 时生效）
+    bool tracking = false;           // 帧间跟踪：只在上一帧圆附近检测，未命中时退回全图
+    int full_search_interval = 30;   // 跟踪模式下强制全图检测的间隔帧数
+    int tracking_margin = 8;         // 跟踪窗口在最大半径之外扩展的像素数
+    bool tiled = false;              // 分块并行检测：图像大于一个瓦片时切成重叠瓦片在共享线程池上检测（批量检测中不生效）
+                                     // 结果与整幅检测一致的前提是 min_dist 小于实际圆心间距：否则整幅检测会按 min_dist
+                                     // 抑制相邻的圆，而瓦片各自检测、只在重叠带内按 min_dist 去重，可能多出这些圆
+    int tile_size = 0;               // 瓦片边长（含重叠带），0 时按 L2 缓存大小确定
+};
+
+// 可视化参数结构体
+struct CircleVisualizationParams {
+    bool show_coordinates = true;    // 是否显示圆心坐标
+    bool draw_connections = true;    // 是否绘制连接线
+    cv::Scalar circle_color = {0, 0, 255};  // 圆颜色
+    cv::Scalar center_color = {0, 255, 0};  // 圆心颜色
+    cv::Scalar line_color = {255, 0, 0};    // 连接线颜色
+};
+
+// 批量检测中单张图像的结果
+struct CircleBatchResult {
+    bool found = false;              // 是否检测到圆（读取失败也为 false）
+    std::vector<cv::Vec3f> circles;  // 检测到的圆
+    std::vector<ImageProcessor::CircleDistance> distances;  // 圆心间距
+};
+
+// 按 params 在单个区域上执行一次霍夫圆检测（detector_type 为 2 且半径带足够窄时走窄带检测器），不分块
+// 检测器和调参工具共用这一分派；可被多个线程同时调用
+void DetectCirclesWithParams(const cv::Mat& gray, const CircleDetectionParams& params,
+                             std::vector<cv::Vec3f>& circles);
+
+// 预处理策略：决定滤波类型、滤波核尺寸和降采样倍数
+// 策略提供 blur_type() / blur_size() / downscale()，编译期策略的三者均为 constexpr，
+// 检测器中依赖它们的分支在编译时消除
+namespace CirclePreprocess {
+
+    constexpr int kNoBlur = 0;
+    constexpr int kMedianBlur = 1;
+    constexpr int kGaussianBlur = 2;
+    constexpr int kBoxBlur = 3;
+
+    // 运行时策略：从 CircleDetectionParams 读取，用于调参
+    class RuntimePreprocess {
+    public:
+        explicit RuntimePreprocess(const CircleDetectionParams& params)
+                : blur_type_(params.blur_type), blur_size_(params.blur_size),
+                  downscale_(params.downscale < 1 ? 1 : params.downscale) {}
+
+        int blur_type() const { return blur_type_; }
+        int blur_size() const { return blur_size_; }
+        int downscale() const { return downscale_; }
+
+    private:
+        int blur_type_;
+        int blur_size_;
+        int downscale_;
     };
 
-    // 可视化参数结构体
-    struct VisualizationParams {
-        bool show_coordinates = true;    // 是否显示圆心坐标
-        bool draw_connections = true;    // 是否绘制连接线
-        cv::Scalar circle_color = {0, 0, 255};  // 圆颜色
-        cv::Scalar center_color = {0, 255, 0};  // 圆心颜色
-        cv::Scalar line_color = {255, 0, 0};    // 连接线颜色
+    // 编译期策略：生产配置固定后使用
+    template <int BlurType, int BlurSize, int Downscale>
+    class FixedPreprocess {
+        static_assert(BlurType >= kNoBlur && BlurType <= kBoxBlur, "unknown blur type");
+        static_assert((BlurType != kMedianBlur && BlurType != kGaussianBlur) || BlurSize % 2 == 1,
+                      "median and Gaussian kernels must be odd");
+        static_assert(Downscale >= 1, "downscale must be positive");
+
+    public:
+        explicit FixedPreprocess(const CircleDetectionParams&) {}
+
+        static constexpr int blur_type() { return BlurType; }
+        static constexpr int blur_size() { return BlurSize; }
+        static constexpr int downscale() { return Downscale; }
     };
 
+    // 按策略对灰度图原地滤波
+    template <class Policy>
+    inline void ApplyBlur(const Policy& policy, cv::Mat& gray) {
+        const cv::Size kernel(policy.blur_size(), policy.blur_size());
+        switch (policy.blur_type()) {
+            case kMedianBlur:
+                cv::medianBlur(gray, gray, policy.blur_size());
+                break;
+            case kGaussianBlur:
+                cv::GaussianBlur(gray, gray, kernel, 2);
+                break;
+            case kBoxBlur:
+                cv::blur(gray, gray, kernel);
+                break;
+            default:
+                break;
+        }
+    }
+
+}  // namespace CirclePreprocess
+
+// 圆检测器类，用于检测图像中的圆并绘制结果
+// Preprocess 为预处理策略；成员函数在 circle_text.cpp 中定义并显式实例化，新增策略时在那里补充
+template <class Preprocess>
+class BasicCircleDetector {
+public:
+    using DetectionParams = CircleDetectionParams;
+    using VisualizationParams = CircleVisualizationParams;
+    using BatchResult = CircleBatchResult;
+
     // 构造函数
-    explicit CircleDetector(const DetectionParams& params = DetectionParams());
+    BasicCircleDetector();
+    explicit BasicCircleDetector(const DetectionParams& params);
 
     // 设置可视化参数
     void set_visualization_params(const VisualizationParams& params);
@@ -38,27 +144,75 @@ public:
     // 检测图像中的圆
     bool detect(const cv::Mat& input_image);
 
-    // 可视化检测结果
+    // 从文件读取并检测，解码时直接降采样
+    bool detect(const std::string& image_path);
+
+    // 批量检测：图像分发到工作窃取线程池，每个执行槽位使用一个独立的检测器（参数同本检测器）
+    // 结果按输入顺序返回；批内图像无先后关系，不做帧间跟踪，也不再分块；pool 为空时使用 WorkStealingPool::Shared()
+    std::vector<BatchResult> detect_batch(std::span<const cv::Mat> images,
+                                          ImageProcessor::WorkStealingPool* pool = nullptr) const;
+    std::vector<BatchResult> detect_batch(std::span<const std::string> image_paths,
+                                          ImageProcessor::WorkStealingPool* pool = nullptr) const;
+
+    // 可视化检测结果，output_image 尺寸和类型不变时直接在其缓冲区上绘制
     void visualize_results(cv::Mat& output_image) const;
 
     // 获取检测到的圆
     const std::vector<cv::Vec3f>& get_detected_circles() const;
 
+    // 获取圆心距离（按 DetectionParams::pitch 测量）
+    const std::vector<ImageProcessor::CircleDistance>& get_distances() const;
+
+    // 按需计算完整距离矩阵（n * n，行优先）
+    void compute_distance_matrix(std::vector<float>& matrix) const;
+
+    // 清除跟踪状态，下一帧执行全图检测
+    void reset_tracking();
+
+    // 跟踪统计（全图/窗口检测次数）
+    CircleTracker::Stats get_tracking_stats() const;
+
 private:
+    // 批量检测的公共实现，Input 为 cv::Mat 或文件路径
+    template <class Input>
+    std::vector<BatchResult> detect_batch_impl(std::span<const Input> inputs,
+                                               ImageProcessor::WorkStealingPool* pool) const;
+
     // 图像预处理
     void preprocess_image(const cv::Mat& input);
 
-    // 计算圆心间距
+    // 对灰度图进行滤波去噪
+    void apply_blur();
+
+    // 在预处理后的图像上执行霍夫圆检测，开启精化且 full_image 非空时在全分辨率图像上精化
+    bool detect_circles(const cv::Mat& full_image);
+
+    // 在灰度图（或其子区域）上执行霍夫圆检测，开启分块时切块并行检测
+    void hough_circles(const cv::Mat& gray, std::vector<cv::Vec3f>& circles) const;
+
+    // 在单个区域上执行一次霍夫圆检测，不分块；可被多个线程同时调用
+    void hough_circles_single(const cv::Mat& gray, std::vector<cv::Vec3f>& circles) const;
+
+    // 计算圆心间距（按亚像素圆心）
     void calculate_distances();
 
     DetectionParams detect_params_;  // 检测参数
+    Preprocess preprocess_;  // 预处理策略
     VisualizationParams visual_params_;  // 可视化参数
+    CircleTracker tracker_;  // 帧间跟踪状态
 
     cv::Mat resized_image_;  // 尺寸调整后的彩色图像
     cv::Mat processed_image_;  // 预处理后的灰度图像
     std::vector<cv::Vec3f> circles_;  // 检测到的圆
-    std::vector<std::pair<cv::Point, cv::Point>> connections_;  // 圆心连接线
-    std::vector<double> distances_;  // 圆心间距
+    std::vector<ImageProcessor::CircleDistance> distances_;  // 圆心间距
 };
 
+// 运行时可配置的检测器（调参、工具）
+using CircleDetector = BasicCircleDetector<CirclePreprocess::RuntimePreprocess>;
+
+// 生产配置：3x3 中值滤波、1/5 降采样，预处理分支在编译期确定；霍夫参数取 CircleDetectionParams 的默认值
+// txma 流水线按同一策略预处理、经 DetectCirclesWithParams 检测
+using ProductionPreprocess = CirclePreprocess::FixedPreprocess<CirclePreprocess::kMedianBlur, 3, 5>;
+using ProductionCircleDetector = BasicCircleDetector<ProductionPreprocess>;
+
 #endif  // IMAGE_PROCESSING_CIRCLE_DETECTOR_H_
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "circle_tracker.h"
+#include "trace.h"
+#include <algorithm>
+
+CircleTracker::CircleTracker() : CircleTracker(Params()) {}
+
+CircleTracker::CircleTracker(const Params& params) : params_(params) {
+    params_.full_search_interval = std::max(1, params_.full_search_interval);
+    params_.search_margin = std::max(1, params_.search_margin);
+}
+
+void CircleTracker::Detect(const cv::Mat& gray, int max_radius, const DetectFn& detect,
+                           std::vector<cv::Vec3f>& circles) {
+    std::vector<cv::Vec3f> previous;
+    bool full_search;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        full_search = previous_.empty() || frames_since_full_ >= params_.full_search_interval;
+        if (!full_search) previous = previous_;
+    }
+
+    bool missed = false;
+    if (!full_search) {
+        if (DetectInWindows(gray, max_radius, detect, previous, circles)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            previous_ = circles;
+            ++frames_since_full_;
+            ++stats_.window_searches;
+            return;
+        }
+        missed = true;
+    }
+
+    {
+        TXMA_TRACE_SCOPE("CircleTracker.FullSearch");
+        detect(gray, circles);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    previous_ = circles;
+    frames_since_full_ = 0;
+    ++stats_.full_searches;
+    if (missed) ++stats_.misses;
+}
+
+bool CircleTracker::DetectInWindows(const cv::Mat& gray, int max_radius, const DetectFn& detect,
+                                    const std::vector<cv::Vec3f>& previous,
+                                    std::vector<cv::Vec3f>& circles) const {
+    TXMA_TRACE_SCOPE("CircleTracker.WindowSearch");
+    const int half = max_radius + params_.search_margin;
+    const float max_shift = static_cast<float>(params_.search_margin);
+    const cv::Rect bounds(0, 0, gray.cols, gray.rows);
+
+    std::vector<cv::Vec3f> tracked;
+    tracked.reserve(previous.size());
+    std::vector<cv::Vec3f> candidates;
+    for (const auto& last : previous) {
+        const cv::Rect window = cv::Rect(cvRound(last[0]) - half, cvRound(last[1]) - half,
+                                         2 * half + 1, 2 * half + 1) & bounds;
+        if (window.empty()) return false;
+
+        candidates.clear();
+        detect(gray(window), candidates);
+
+        // 窗口内可能露出相邻圆的一部分，取离上一帧圆心最近且位移不超过边距的候选
+        const cv::Point2f last_center(last[0] - window.x, last[1] - window.y);
+        const cv::Vec3f* best = nullptr;
+        float best_shift = max_shift;
+        for (const auto& candidate : candidates) {
+            const float shift = static_cast<float>(cv::norm(cv::Point2f(candidate[0], candidate[1]) - last_center));
+            if (shift <= best_shift) {
+                best_shift = shift;
+                best = &candidate;
+            }
+        }
+        if (!best) return false;
+
+        tracked.emplace_back((*best)[0] + window.x, (*best)[1] + window.y, (*best)[2]);
+    }
+
+    circles = std::move(tracked);
+    return true;
+}
+
+void CircleTracker::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    previous_.clear();
+    frames_since_full_ = 0;
+}
+
+CircleTracker::Stats CircleTracker::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef CIRCLE_TRACKER_H
+#define CIRCLE_TRACKER_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// 帧间圆跟踪：工件在相邻帧中位置基本不变，只在上一帧圆的周围小窗口内重新检测
+// 任一圆在窗口内未找到或距上次全图搜索已满 full_search_interval 帧时，退回全图检测
+class CircleTracker {
+public:
+    // 跟踪参数
+    struct Params {
+        int full_search_interval = 30;  // 每隔多少帧强制全图检测一次，用于发现新出现的圆
+        int search_margin = 8;          // 窗口在最大半径之外扩展的像素数，也是允许的最大帧间位移
+    };
+
+    // 统计信息
+    struct Stats {
+        uint64_t full_searches = 0;     // 全图检测次数
+        uint64_t window_searches = 0;   // 窗口检测成功的帧数
+        uint64_t misses = 0;            // 窗口检测未命中后退回全图的帧数
+    };
+
+    // 在灰度图（或其子区域）上执行一次圆检测，结果坐标相对于传入的图像
+    using DetectFn = std::function<void(const cv::Mat& gray, std::vector<cv::Vec3f>& circles)>;
+
+    CircleTracker();
+    explicit CircleTracker(const Params& params);
+
+    // 检测一帧：gray 为预处理后的灰度图，max_radius 为检测的最大半径
+    // 窗口检测命中时圆的顺序与上一帧一致；可从多个线程调用，检测本身不持锁
+    void Detect(const cv::Mat& gray, int max_radius, const DetectFn& detect,
+                std::vector<cv::Vec3f>& circles);
+
+    // 清除跟踪状态，下一帧执行全图检测（例如切换工件或相机移动后）
+    void Reset();
+
+    Stats GetStats() const;
+
+private:
+    // 在上一帧每个圆周围的窗口中检测，全部命中时返回 true
+    bool DetectInWindows(const cv::Mat& gray, int max_radius, const DetectFn& detect,
+                         const std::vector<cv::Vec3f>& previous, std::vector<cv::Vec3f>& circles) const;
+
+    Params params_;
+    mutable std::mutex mutex_;
+    std::vector<cv::Vec3f> previous_;    // 最近一帧的检测结果
+    int frames_since_full_ = 0;          // 距上次全图检测的帧数
+    Stats stats_;
+};
+
+#endif  // CIRCLE_TRACKER_H
\ No newline at end of file
@@ -0,0 +1,414 @@
+#include "fast_morphology.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TXMA_MORPH_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TXMA_MORPH_NEON 1
+#endif
+
+namespace FastMorphology {
+
+    namespace {
+
+        // 一个向量的字节数，也是横向滤波一次转置的行数
+        constexpr int kLanes = 16;
+
+        // 横向窗口不超过该长度时逐行用倍增法直接滤波（每像素 ceil(log2 k) 次比较），
+        // 更长的窗口转置后做 van Herk/Gil-Werman（每像素比较次数固定，但转置开销较大，窗口约 100 以上才持平）
+        constexpr int kDirectWindowLimit = 64;
+
+#if defined(TXMA_MORPH_SSE2)
+        using Vec = __m128i;
+        inline Vec Load(const uchar* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        inline void Store(uchar* p, Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+        inline Vec Splat(uchar value) { return _mm_set1_epi8(static_cast<char>(value)); }
+        inline Vec Max(Vec a, Vec b) { return _mm_max_epu8(a, b); }
+        inline Vec Min(Vec a, Vec b) { return _mm_min_epu8(a, b); }
+        inline void Zip(Vec a, Vec b, Vec& lo, Vec& hi) {
+            lo = _mm_unpacklo_epi8(a, b);
+            hi = _mm_unpackhi_epi8(a, b);
+        }
+#elif defined(TXMA_MORPH_NEON)
+        using Vec = uint8x16_t;
+        inline Vec Load(const uchar* p) { return vld1q_u8(p); }
+        inline void Store(uchar* p, Vec v) { vst1q_u8(p, v); }
+        inline Vec Splat(uchar value) { return vdupq_n_u8(value); }
+        inline Vec Max(Vec a, Vec b) { return vmaxq_u8(a, b); }
+        inline Vec Min(Vec a, Vec b) { return vminq_u8(a, b); }
+        inline void Zip(Vec a, Vec b, Vec& lo, Vec& hi) {
+            const uint8x16x2_t zipped = vzipq_u8(a, b);
+            lo = zipped.val[0];
+            hi = zipped.val[1];
+        }
+#else
+        struct Vec {
+            uchar v[kLanes];
+        };
+        inline Vec Load(const uchar* p) {
+            Vec r;
+            std::memcpy(r.v, p, kLanes);
+            return r;
+        }
+        inline void Store(uchar* p, const Vec& v) { std::memcpy(p, v.v, kLanes); }
+        inline Vec Splat(uchar value) {
+            Vec r;
+            std::fill(r.v, r.v + kLanes, value);
+            return r;
+        }
+        inline Vec Max(const Vec& a, const Vec& b) {
+            Vec r;
+            for (int i = 0; i < kLanes; ++i) r.v[i] = std::max(a.v[i], b.v[i]);
+            return r;
+        }
+        inline Vec Min(const Vec& a, const Vec& b) {
+            Vec r;
+            for (int i = 0; i < kLanes; ++i) r.v[i] = std::min(a.v[i], b.v[i]);
+            return r;
+        }
+        inline void Zip(const Vec& a, const Vec& b, Vec& lo, Vec& hi) {
+            for (int i = 0; i < kLanes / 2; ++i) {
+                lo.v[2 * i] = a.v[i];
+                lo.v[2 * i + 1] = b.v[i];
+                hi.v[2 * i] = a.v[kLanes / 2 + i];
+                hi.v[2 * i + 1] = b.v[kLanes / 2 + i];
+            }
+        }
+#endif
+
+        struct MaxOp {
+            static constexpr uchar kNeutral = 0;
+            static Vec Apply(const Vec& a, const Vec& b) { return Max(a, b); }
+        };
+
+        struct MinOp {
+            static constexpr uchar kNeutral = 255;
+            static Vec Apply(const Vec& a, const Vec& b) { return Min(a, b); }
+        };
+
+        // 一轮字节交错：out[2i] / out[2i + 1] 为 in[i] 与 in[i + 8] 的低 / 高半部分交错
+        inline void ZipPass(const Vec in[kLanes], Vec out[kLanes]) {
+            for (int i = 0; i < kLanes / 2; ++i) {
+                Zip(in[i], in[i + kLanes / 2], out[2 * i], out[2 * i + 1]);
+            }
+        }
+
+        // 16x16 字节转置：连续四轮字节交错
+        inline void Transpose16(Vec v[kLanes]) {
+            Vec t[kLanes];
+            ZipPass(v, t);
+            ZipPass(t, v);
+            ZipPass(v, t);
+            ZipPass(t, v);
+        }
+
+        // 行缓冲宽度，补齐到向量长度，各级相同
+        inline int RowStride(int cols) {
+            return (cols + kLanes - 1) / kLanes * kLanes;
+        }
+
+        // 逐行接收图像的一级：上一级直接写入 RowBuffer()（宽度为 RowStride），再调用 Commit()
+        class RowSink {
+        public:
+            virtual ~RowSink() = default;
+            virtual uchar* RowBuffer() = 0;
+            virtual void Commit() = 0;
+            virtual void Finish() = 0;
+        };
+
+        // 最后一级：按顺序写入输出图像（输出行宽度不足 RowStride，经一行缓冲复制）
+        class MatSink : public RowSink {
+        public:
+            explicit MatSink(cv::Mat& dst) : dst_(dst), row_(RowStride(dst.cols)) {}
+            uchar* RowBuffer() override { return row_.data(); }
+            void Commit() override { std::memcpy(dst_.ptr<uchar>(y_++), row_.data(), dst_.cols); }
+            void Finish() override {}
+
+        private:
+            cv::Mat& dst_;
+            std::vector<uchar> row_;
+            int y_ = 0;
+        };
+
+        // 一步形态学运算：16 行凑齐后做横向滤波，结果逐行进入纵向滤波，纵向滤波的输出交给下一级
+        // van Herk/Gil-Werman：序列按窗口长度 k 分块，块内前缀 g 与后缀 h 各扫描一次，
+        // 起点为 i 的窗口结果为 op(h[i], g[i + k - 1])；序列两端补 before / after 个中性值
+        class StageBase : public RowSink {
+        public:
+            StageBase(const Step& step, int cols)
+                    : step_(step), cols_(cols), window_(step.before + step.after + 1), stride_(RowStride(cols)) {}
+
+            bool Matches(const Step& step, int cols) const {
+                return step.operation == step_.operation && step.before == step_.before &&
+                       step.after == step_.after && cols == cols_;
+            }
+
+            // 开始处理新图像，输出交给 next
+            virtual void Reset(RowSink* next) = 0;
+
+        protected:
+            const Step step_;
+            const int cols_;
+            const int window_;  // 窗口长度 k
+            const int stride_;  // 行缓冲宽度，补齐到向量长度
+        };
+
+        template <class Op>
+        class Stage : public StageBase {
+        public:
+            Stage(const Step& step, int cols) : StageBase(step, cols) {
+                strip_.resize(static_cast<size_t>(kLanes) * stride_);
+                neutral_.assign(stride_, Op::kNeutral);
+
+                if (direct_) {
+                    // 行两端补 before / after 个中性值，尾部再留出倍增读取越过的余量
+                    padded_length_ = step_.before + stride_ + step_.after;
+                    const size_t size = static_cast<size_t>(padded_length_) + window_ + 2 * kLanes;
+                    padded_.assign(size, Op::kNeutral);
+                    doubled_.assign(size, Op::kNeutral);
+                }
+
+                // 横向序列：前 before 个中性值 + cols 列 + 后补中性值，长度补齐到 k 的整数倍，
+                // 并保证补齐宽度的每一列都有完整窗口
+                const int length = std::max(step_.before + cols_ + step_.after, stride_ + window_ - 1);
+                sequence_length_ = (length + window_ - 1) / window_ * window_;
+                sequence_.resize(static_cast<size_t>(sequence_length_) * kLanes);
+                prefix_.resize(static_cast<size_t>(sequence_length_) * kLanes);
+
+                raw_.resize(static_cast<size_t>(window_) * stride_);
+                block_suffix_.resize(static_cast<size_t>(window_) * stride_);
+                running_.resize(stride_);
+            }
+
+            void Reset(RowSink* next) override {
+                next_ = next;
+                strip_rows_ = 0;
+                pushed_ = 0;
+                for (int i = 0; i < step_.before; ++i) PushVertical(neutral_.data());
+            }
+
+            uchar* RowBuffer() override {
+                return strip_.data() + static_cast<size_t>(strip_rows_) * stride_;
+            }
+
+            void Commit() override {
+                if (direct_) {
+                    HorizontalDirect(strip_.data());
+                    PushVertical(strip_.data());
+                    return;
+                }
+                if (++strip_rows_ == kLanes) FlushStrip();
+            }
+
+            void Finish() override {
+                FlushStrip();
+                for (int i = 0; i < step_.after; ++i) PushVertical(neutral_.data());
+                next_->Finish();
+            }
+
+        private:
+            void FlushStrip() {
+                if (strip_rows_ == 0) return;
+                Horizontal();
+                for (int r = 0; r < strip_rows_; ++r) {
+                    PushVertical(strip_.data() + static_cast<size_t>(r) * stride_);
+                }
+                strip_rows_ = 0;
+            }
+
+            // 短窗口的单行横向滤波（原地）：第 j 轮得到长度 2^j 的窗口结果，
+            // 最后用两个重叠的 2^j 窗口拼出长度 k 的窗口，共 ceil(log2 k) 轮
+            void HorizontalDirect(uchar* row) {
+                std::memcpy(padded_.data() + step_.before, row, cols_);
+                const int length = (padded_length_ + kLanes - 1) / kLanes * kLanes;
+
+                const uchar* current = padded_.data();
+                int width = 1;
+                while (width * 2 <= window_) {
+                    uchar* target = doubled_.data();
+                    for (int x = 0; x < length; x += kLanes) {
+                        Store(target + x, Op::Apply(Load(current + x), Load(current + x + width)));
+                    }
+                    // 原地更新：每个位置只依赖自身及其后的旧值
+                    current = target;
+                    width *= 2;
+                }
+
+                const int shift = window_ - width;
+                for (int x = 0; x < stride_; x += kLanes) {
+                    Store(row + x, Op::Apply(Load(current + x), Load(current + x + shift)));
+                }
+            }
+
+            // 对缓冲的 16 行做横向滤波（原地）：每 16 列转置为 16 个向量（每个向量是同一列的 16 行），
+            // 正向扫描时保存原值和块内前缀，反向扫描时块内后缀只保留在寄存器中，直接与 k - 1 之后的前缀
+            // 组合出结果，每凑齐 16 列转置回行
+            void Horizontal() {
+                uchar* sequence = sequence_.data();
+                uchar* prefix = prefix_.data();
+                auto at = [](uchar* base, int i) { return base + static_cast<size_t>(i) * kLanes; };
+
+                const Vec neutral = Splat(Op::kNeutral);
+                Vec acc = neutral;
+                int index = 0;
+                int phase = 0;  // index 在所在块中的位置
+                auto forward = [&](const Vec& value) {
+                    acc = phase == 0 ? value : Op::Apply(acc, value);
+                    Store(at(sequence, index), value);
+                    Store(at(prefix, index), acc);
+                    ++index;
+                    if (++phase == window_) phase = 0;
+                };
+
+                Vec block[kLanes];
+                for (int i = 0; i < step_.before; ++i) forward(neutral);
+                for (int x = 0; x < cols_; x += kLanes) {
+                    for (int r = 0; r < kLanes; ++r) {
+                        block[r] = Load(strip_.data() + static_cast<size_t>(r) * stride_ + x);
+                    }
+                    Transpose16(block);
+                    const int columns = std::min(kLanes, cols_ - x);
+                    for (int c = 0; c < columns; ++c) forward(block[c]);
+                }
+                while (index < sequence_length_) forward(neutral);
+
+                // 从包含最后一列的块的末尾开始反向扫描
+                const int top = ((stride_ - 1) / window_ + 1) * window_ - 1;
+                phase = 0;
+                for (int i = top; i >= 0; --i) {
+                    const Vec value = Load(at(sequence, i));
+                    acc = phase == 0 ? value : Op::Apply(value, acc);
+                    if (++phase == window_) phase = 0;
+                    if (i >= stride_) continue;
+
+                    block[i % kLanes] = Op::Apply(acc, Load(at(prefix, i + window_ - 1)));
+                    if (i % kLanes == 0) {
+                        Transpose16(block);
+                        for (int r = 0; r < kLanes; ++r) {
+                            Store(strip_.data() + static_cast<size_t>(r) * stride_ + i, block[r]);
+                        }
+                    }
+                }
+            }
+
+            // 纵向滤波输入一行（补中性行后的第 pushed_ 行），窗口末行到达时输出窗口起点所在行
+            void PushVertical(const uchar* row) {
+                const int slot = static_cast<int>(pushed_ % window_);
+                uchar* raw = raw_.data() + static_cast<size_t>(slot) * stride_;
+                uchar* running = running_.data();
+                const bool emit = pushed_ >= window_ - 1;
+                uchar* output = emit ? next_->RowBuffer() : nullptr;
+                const bool block_end = slot == window_ - 1;
+                // 窗口起点在上一块时，结果为上一块的后缀与本块前缀的组合
+                const uchar* previous = block_suffix_.data() + static_cast<size_t>((slot + 1) % window_) * stride_;
+
+                for (int x = 0; x < stride_; x += kLanes) {
+                    const Vec value = Load(row + x);
+                    Store(raw + x, value);
+                    const Vec prefix = slot == 0 ? value : Op::Apply(Load(running + x), value);
+                    Store(running + x, prefix);
+                    if (emit) {
+                        Store(output + x, block_end ? prefix : Op::Apply(Load(previous + x), prefix));
+                    }
+                }
+                if (emit) next_->Commit();
+
+                // 块结束：从后向前计算本块后缀，供下一块的窗口使用
+                if (block_end) {
+                    uchar* suffix = block_suffix_.data();
+                    std::memcpy(suffix + static_cast<size_t>(slot) * stride_, raw, stride_);
+                    for (int i = window_ - 2; i >= 0; --i) {
+                        const uchar* source = raw_.data() + static_cast<size_t>(i) * stride_;
+                        const uchar* next = suffix + static_cast<size_t>(i + 1) * stride_;
+                        uchar* target = suffix + static_cast<size_t>(i) * stride_;
+                        for (int x = 0; x < stride_; x += kLanes) {
+                            Store(target + x, Op::Apply(Load(source + x), Load(next + x)));
+                        }
+                    }
+                }
+                ++pushed_;
+            }
+
+            RowSink* next_ = nullptr;
+            const bool direct_ = window_ <= kDirectWindowLimit;
+
+            int padded_length_ = 0;
+            std::vector<uchar> padded_;   // 短窗口：两端补中性值的输入行
+            std::vector<uchar> doubled_;  // 短窗口：倍增中间结果（原地更新）
+
+            std::vector<uchar> strip_;   // 待横向滤波的 16 行
+            int strip_rows_ = 0;
+            std::vector<uchar> neutral_;  // 中性值行（膨胀为 0，腐蚀为 255）
+
+            int sequence_length_ = 0;
+            std::vector<uchar> sequence_;  // 横向序列（每列 16 字节）
+            std::vector<uchar> prefix_;    // 横向块内前缀
+
+            int64_t pushed_ = 0;              // 纵向已输入的行数（含补的中性行）
+            std::vector<uchar> raw_;          // 当前块的输入行
+            std::vector<uchar> block_suffix_;  // 上一块的后缀行
+            std::vector<uchar> running_;      // 当前块的前缀
+        };
+
+        // 每个线程缓存上次使用的各级，参数和宽度不变时复用缓冲区
+        thread_local std::vector<std::unique_ptr<StageBase>> cached_stages;
+
+        StageBase& CachedStage(size_t index, const Step& step, int cols) {
+            if (cached_stages.size() <= index) cached_stages.resize(index + 1);
+            std::unique_ptr<StageBase>& stage = cached_stages[index];
+            if (!stage || !stage->Matches(step, cols)) {
+                if (step.operation == Operation::kDilate) {
+                    stage = std::make_unique<Stage<MaxOp>>(step, cols);
+                } else {
+                    stage = std::make_unique<Stage<MinOp>>(step, cols);
+                }
+            }
+            return *stage;
+        }
+
+    }  // namespace
+
+    Step Step::Rect(Operation operation, int size) {
+        size = std::max(size, 1);
+        return Step{operation, size / 2, size - 1 - size / 2};
+    }
+
+    void Apply(const cv::Mat& src, cv::Mat& dst, const std::vector<Step>& steps) {
+        CV_Assert(src.type() == CV_8UC1);
+        TXMA_TRACE_SCOPE("FastMorphology.Apply");
+        if (steps.empty() || src.empty()) {
+            src.copyTo(dst);
+            return;
+        }
+        dst.create(src.rows, src.cols, CV_8UC1);
+
+        // 从最后一级向前连接
+        MatSink sink(dst);
+        RowSink* next = &sink;
+        for (size_t i = steps.size(); i-- > 0;) {
+            StageBase& stage = CachedStage(i, steps[i], src.cols);
+            stage.Reset(next);
+            next = &stage;
+        }
+
+        for (int y = 0; y < src.rows; ++y) {
+            std::memcpy(next->RowBuffer(), src.ptr<uchar>(y), src.cols);
+            next->Commit();
+        }
+        next->Finish();
+    }
+
+    void CloseErodeDilate(const cv::Mat& binary, cv::Mat& dst, int size) {
+        // 闭运算 = 膨胀 + 腐蚀；两次 size 腐蚀等价于一次窗口加倍的腐蚀（图像外不参与时严格相等）
+        const Step dilate = Step::Rect(Operation::kDilate, size);
+        const Step erode{Operation::kErode, 2 * dilate.before, 2 * dilate.after};
+        Apply(binary, dst, {dilate, erode, dilate});
+    }
+
+}  // namespace FastMorphology
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef FAST_MORPHOLOGY_H
+#define FAST_MORPHOLOGY_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace FastMorphology {
+
+    // 形态学运算类型
+    enum class Operation {
+        kDilate,  // 窗口内取最大值
+        kErode    // 窗口内取最小值
+    };
+
+    // 一步方形矩形结构元素的运算，窗口为 [x - before, x + after] x [y - before, y + after]
+    struct Step {
+        Operation operation;
+        int before;
+        int after;
+
+        // size x size 矩形，锚点与 cv::getStructuringElement(MORPH_RECT) 默认值一致
+        static Step Rect(Operation operation, int size);
+    };
+
+    // 按顺序执行 steps，全部步骤在一次逐行流式扫描中完成，结果与逐步调用 cv::dilate / cv::erode 一致
+    // 每步分离为横向和纵向一维滤波：纵向按 van Herk/Gil-Werman，每像素比较次数与窗口大小无关，每步只保留两个窗口长度的行；
+    // 横向短窗口逐行倍增，长窗口以 16 行为一组转置后同样做 van Herk/Gil-Werman
+    // 图像外的像素不参与运算（OpenCV 形态学的默认边界）；src 必须为 CV_8UC1，尺寸不变时复用 dst 的缓冲区
+    void Apply(const cv::Mat& src, cv::Mat& dst, const std::vector<Step>& steps);
+
+    // 闭运算 -> 腐蚀 -> 膨胀（size x size 矩形），闭运算中的腐蚀与其后的腐蚀合并为一步，共三步
+    void CloseErodeDilate(const cv::Mat& binary, cv::Mat& dst, int size);
+
+}  // namespace FastMorphology
+
+#endif  // FAST_MORPHOLOGY_H
\ No newline at end of file
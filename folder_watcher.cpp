@@ -0,0 +1,247 @@
+#include "folder_watcher.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace ImageProcessor {
+
+    namespace {
+
+        // PNG 文件尾部固定为 IEND 块：长度 0 + "IEND" + CRC
+        constexpr unsigned char kPngTrailer[12] = {
+                0x00, 0x00, 0x00, 0x00, 'I', 'E', 'N', 'D', 0xAE, 0x42, 0x60, 0x82};
+
+        // 轮询模式下的扫描间隔
+        constexpr int kPollIntervalMs = 100;
+
+        void SortByNumber(std::vector<WatchedFile>& files) {
+            std::sort(files.begin(), files.end(),
+                      [](const WatchedFile& a, const WatchedFile& b) { return a.number < b.number; });
+        }
+
+    }  // namespace
+
+    FolderWatcher::FolderWatcher(const std::string& folder_path, const ImageIngest::RawFormat& raw)
+            : folder_path_(folder_path), raw_(raw),
+              newest_reported_(fs::file_time_type::clock::now()) {
+#ifdef __linux__
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd_ >= 0) {
+            // 只关心写完关闭和移入的文件，写入过程中的文件不会触发事件
+            watch_fd_ = inotify_add_watch(inotify_fd_, folder_path_.c_str(),
+                                          IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (watch_fd_ < 0) {
+                close(inotify_fd_);
+                inotify_fd_ = -1;
+            }
+        }
+#endif
+        if (inotify_fd_ < 0) {
+            std::cerr << "inotify unavailable, falling back to directory polling" << std::endl;
+        }
+    }
+
+    FolderWatcher::~FolderWatcher() {
+#ifdef __linux__
+        if (inotify_fd_ >= 0) {
+            close(inotify_fd_);
+        }
+#endif
+    }
+
+    bool FolderWatcher::ParseFrameNumber(const std::string& filename, int64_t& number) {
+        const std::string prefix = "Image_";
+        constexpr size_t kSuffixSize = 4;
+        if (filename.size() <= prefix.size() + kSuffixSize ||
+            filename.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+        const std::string suffix = filename.substr(filename.size() - kSuffixSize);
+        if (suffix != ".png" && suffix != ".pgm" && suffix != ".ppm" && suffix != ".bmp" && suffix != ".raw") {
+            return false;
+        }
+
+        const char* first = filename.data() + prefix.size();
+        const char* last = filename.data() + filename.size() - kSuffixSize;
+        const auto [end, ec] = std::from_chars(first, last, number);
+        return ec == std::errc() && end == last && number >= 0;
+    }
+
+    bool FolderWatcher::Accepts(const std::string& filename, int64_t& number) const {
+        if (!ParseFrameNumber(filename, number)) return false;
+        return raw_.width > 0 || filename.compare(filename.size() - 4, 4, ".raw") != 0;
+    }
+
+    bool FolderWatcher::IsFileComplete(const std::string& filename) const {
+        std::ifstream file(folder_path_ + filename, std::ios::binary);
+        if (!file) return false;
+
+        // 未压缩格式没有结尾标记，按文件头算出的总长度判断
+        if (ImageIngest::IsUncompressedImage(filename)) {
+            unsigned char head[ImageIngest::kHeaderProbeBytes];
+            file.read(reinterpret_cast<char*>(head), sizeof(head));
+            const size_t head_size = static_cast<size_t>(file.gcount());
+            const size_t expected = ImageIngest::ExpectedFileSize(filename, head, head_size, raw_);
+            file.clear();
+            file.seekg(0, std::ios::end);
+            return expected > 0 && file.tellg() >= static_cast<std::streamoff>(expected);
+        }
+
+        file.seekg(0, std::ios::end);
+        if (file.tellg() < static_cast<std::streamoff>(sizeof(kPngTrailer))) return false;
+
+        unsigned char trailer[sizeof(kPngTrailer)];
+        file.seekg(-static_cast<std::streamoff>(sizeof(kPngTrailer)), std::ios::end);
+        file.read(reinterpret_cast<char*>(trailer), sizeof(trailer));
+        return file && std::memcmp(trailer, kPngTrailer, sizeof(kPngTrailer)) == 0;
+    }
+
+    std::vector<WatchedFile> FolderWatcher::ScanExisting(int64_t after_number) {
+        std::vector<WatchedFile> files = ListCompleteFiles(after_number);
+        if (!UsingInotify()) {
+            for (const auto& file : files) {
+                reported_.insert(file.number);
+                newest_reported_ = std::max(newest_reported_, file.modified);
+            }
+        }
+        return files;
+    }
+
+    std::vector<WatchedFile> FolderWatcher::ListCompleteFiles(int64_t after_number, std::vector<WatchedFile>* skipped,
+                                                              fs::file_time_type newer_than) const {
+        std::vector<WatchedFile> files;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(folder_path_, ec)) {
+            WatchedFile file;
+            file.filename = entry.path().filename().string();
+            if (!Accepts(file.filename, file.number))
+                continue;
+            if (file.number <= after_number) {
+                std::error_code time_ec;
+                if (skipped && entry.last_write_time(time_ec) > newer_than && !time_ec) {
+                    skipped->push_back(std::move(file));
+                }
+                continue;
+            }
+
+            // 尚未写完的文件跳过，写完时会由 inotify 事件或下一次轮询上报
+            std::error_code time_ec;
+            file.modified = entry.last_write_time(time_ec);
+            if (entry.is_regular_file() && IsFileComplete(file.filename)) {
+                files.push_back(std::move(file));
+            }
+        }
+        if (ec) {
+            std::cerr << "Unable to scan folder: " << folder_path_ << " (" << ec.message() << ")" << std::endl;
+        }
+        SortByNumber(files);
+        return files;
+    }
+
+    int64_t FolderWatcher::FindCounterReset(int64_t watermark, fs::file_time_type since) const {
+        int64_t reset = -1;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(folder_path_, ec)) {
+            const std::string filename = entry.path().filename().string();
+            int64_t number;
+            if (!Accepts(filename, number) || number > watermark || (reset >= 0 && number >= reset))
+                continue;
+
+            std::error_code time_ec;
+            if (entry.is_regular_file() && entry.last_write_time(time_ec) > since && !time_ec &&
+                IsFileComplete(filename)) {
+                reset = number;
+            }
+        }
+        return reset;
+    }
+
+    void FolderWatcher::ReportSkipped(const WatchedFile& file, int64_t after_number) {
+        if (!skipped_.insert(file.filename).second) return;
+        std::cerr << "Skipping new file " << file.filename << ": frame number is not above the processed watermark "
+                  << after_number << " (camera counter reset? it is picked up on restart)" << std::endl;
+    }
+
+    std::vector<WatchedFile> FolderWatcher::PollNewFiles(int64_t after_number) {
+        // 水位以下的编号不会再上报，及时清理保证集合有界
+        reported_.erase(reported_.begin(), reported_.upper_bound(after_number));
+
+        std::vector<WatchedFile> skipped;
+        std::vector<WatchedFile> complete = ListCompleteFiles(after_number, &skipped, newest_reported_);
+        for (const auto& file : skipped) ReportSkipped(file, after_number);
+
+        std::vector<WatchedFile> files;
+        for (auto& file : complete) {
+            if (reported_.insert(file.number).second) {
+                newest_reported_ = std::max(newest_reported_, file.modified);
+                files.push_back(std::move(file));
+            }
+        }
+        return files;
+    }
+
+    std::vector<WatchedFile> FolderWatcher::WaitForFiles(int timeout_ms, int64_t after_number) {
+#ifdef __linux__
+        if (inotify_fd_ >= 0) {
+            pollfd pfd{inotify_fd_, POLLIN, 0};
+            if (poll(&pfd, 1, timeout_ms) <= 0) return {};
+
+            std::vector<WatchedFile> files;
+            alignas(inotify_event) char buffer[16 * 1024];
+            bool overflow = false;
+            ssize_t len;
+            while ((len = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+                for (char* ptr = buffer; ptr < buffer + len;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(ptr);
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        overflow = true;
+                    } else if (event->len > 0) {
+                        WatchedFile file;
+                        file.filename = event->name;
+                        if (Accepts(file.filename, file.number)) {
+                            // 事件只在文件写完时产生，水位以下的事件就是被跳过的新文件
+                            if (file.number > after_number) {
+                                files.push_back(std::move(file));
+                            } else {
+                                ReportSkipped(file, after_number);
+                            }
+                        }
+                    }
+                    ptr += sizeof(inotify_event) + event->len;
+                }
+            }
+
+            // 事件队列溢出时丢失了部分通知，重新扫描目录补齐
+            if (overflow) {
+                std::cerr << "inotify queue overflow, rescanning folder" << std::endl;
+                return ListCompleteFiles(after_number);
+            }
+            SortByNumber(files);
+            return files;
+        }
+#endif
+        // 轮询模式：间隔扫描目录直到发现新文件或超时
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (true) {
+            std::vector<WatchedFile> files = PollNewFiles(after_number);
+            if (!files.empty() || std::chrono::steady_clock::now() >= deadline) {
+                return files;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMs));
+        }
+    }
+
+}  // namespace ImageProcessor
\ No newline at end of file
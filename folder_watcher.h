@@ -0,0 +1,80 @@
+#ifndef FOLDER_WATCHER_H
+#define FOLDER_WATCHER_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <set>
+#include "mapped_image.h"
+
+namespace ImageProcessor {
+
+// 监视到的图像文件
+    struct WatchedFile {
+        int64_t number = 0;     // 文件名中的帧编号
+        std::string filename;   // 文件名
+        std::filesystem::file_time_type modified{};  // 修改时间（仅目录扫描时填写）
+    };
+
+// 文件夹监视器，Linux 下基于 inotify 事件唤醒，其他平台退化为目录轮询
+    class FolderWatcher {
+    public:
+        // raw 为 .raw 帧的格式，未设置时忽略 .raw 文件
+        explicit FolderWatcher(const std::string& folder_path,
+                               const ImageIngest::RawFormat& raw = ImageIngest::RawFormat());
+        ~FolderWatcher();
+
+        FolderWatcher(const FolderWatcher&) = delete;
+        FolderWatcher& operator=(const FolderWatcher&) = delete;
+
+        // 启动补扫：列出目录中帧编号大于 after_number 且已写完的图像，按编号排序
+        std::vector<WatchedFile> ScanExisting(int64_t after_number);
+
+        // 等待帧编号大于 after_number 的新图像写完，最多等待 timeout_ms 毫秒，按编号排序
+        // 超时返回空列表
+        std::vector<WatchedFile> WaitForFiles(int timeout_ms, int64_t after_number);
+
+        // 检查相机帧计数是否已重置：帧编号不大于 watermark 但修改时间晚于 since 且已写完的图像中
+        // 返回最小的编号，没有时返回 -1
+        int64_t FindCounterReset(int64_t watermark, std::filesystem::file_time_type since) const;
+
+        // 是否使用 inotify 事件模式
+        bool UsingInotify() const { return inotify_fd_ >= 0; }
+
+        // 解析相机输出的 Image_<编号>.png（或 .pgm / .ppm / .bmp / .raw），文件名不符时返回 false
+        static bool ParseFrameNumber(const std::string& filename, int64_t& number);
+
+    private:
+        // 文件名符合规则且格式可读（.raw 需要已设置格式）
+        bool Accepts(const std::string& filename, int64_t& number) const;
+
+        // 检查文件是否已完整写入（PNG 以 IEND 块结尾，未压缩格式的长度达到文件头声明的大小）
+        bool IsFileComplete(const std::string& filename) const;
+
+        // 列出目录中帧编号大于 after_number 且已写完的图像文件，按编号排序
+        // 先按文件名过滤再检查文件内容，水位以下的文件不做任何 I/O；
+        // skipped 非空时另外收集水位以下、修改时间晚于 newer_than 的文件（只读取目录项的修改时间）
+        std::vector<WatchedFile> ListCompleteFiles(int64_t after_number, std::vector<WatchedFile>* skipped = nullptr,
+                                                   std::filesystem::file_time_type newer_than = {}) const;
+
+        // 记录一个因编号不大于水位而被跳过的新文件，每个文件只提示一次
+        void ReportSkipped(const WatchedFile& file, int64_t after_number);
+
+        // 轮询模式：扫描目录并返回尚未上报过的新文件
+        std::vector<WatchedFile> PollNewFiles(int64_t after_number);
+
+        std::string folder_path_;         // 文件夹路径
+        ImageIngest::RawFormat raw_;      // .raw 帧的格式
+        int inotify_fd_ = -1;             // inotify 文件描述符，-1 表示轮询模式
+        int watch_fd_ = -1;               // inotify 监视描述符
+        std::set<int64_t> reported_;      // 轮询模式下已上报且高于水位的帧编号
+        std::set<std::string> skipped_;   // 已提示过的水位以下的新文件
+        // 轮询模式下已上报文件的最新修改时间（初始为监视器创建时间）；
+        // 水位以下的文件比它还新，说明是上报之后才写入的，即被跳过的新文件
+        std::filesystem::file_time_type newest_reported_;
+    };
+
+}  // namespace ImageProcessor
+
+#endif  // FOLDER_WATCHER_H
\ No newline at end of file
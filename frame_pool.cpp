@@ -0,0 +1,76 @@
+#include "frame_pool.h"
+
+namespace ImageProcessor {
+
+    namespace {
+
+        // 只有池自己持有引用时缓冲区空闲（与 cv::Mat 内部的引用计数方式一致）
+        bool IsFree(const cv::Mat& mat) {
+            return mat.u && CV_XADD(&mat.u->refcount, 0) == 1;
+        }
+
+    }  // namespace
+
+    FramePool& FramePool::Shared() {
+        static FramePool pool;
+        return pool;
+    }
+
+    cv::Mat FramePool::Acquire(cv::Size size, int type) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Bucket& bucket = buffers_[Key(size.height, size.width, type)];
+        bucket.last_acquire = ++acquire_count_;
+        for (const cv::Mat& mat : bucket.mats) {
+            if (IsFree(mat)) {
+                ++stats_.reuses;
+                return mat;
+            }
+        }
+
+        // 稳态下不会走到这里；尺寸变化后旧尺寸的缓冲区在此释放
+        if (acquire_count_ > kIdleAcquires) TrimLocked(acquire_count_ - kIdleAcquires);
+
+        bucket.mats.emplace_back(size, type);
+        ++stats_.allocations;
+        ++stats_.pooled_buffers;
+        stats_.pooled_bytes += bucket.mats.back().total() * bucket.mats.back().elemSize();
+        return bucket.mats.back();
+    }
+
+    void FramePool::Ensure(cv::Mat& mat, cv::Size size, int type) {
+        if (mat.size() == size && mat.type() == type) return;
+        mat = Acquire(size, type);
+    }
+
+    void FramePool::Trim() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TrimLocked(acquire_count_);
+    }
+
+    void FramePool::TrimLocked(uint64_t before) {
+        for (auto it = buffers_.begin(); it != buffers_.end();) {
+            if (it->second.last_acquire > before) {
+                ++it;
+                continue;
+            }
+            std::vector<cv::Mat>& bucket = it->second.mats;
+            for (size_t i = 0; i < bucket.size();) {
+                if (IsFree(bucket[i])) {
+                    stats_.pooled_bytes -= bucket[i].total() * bucket[i].elemSize();
+                    --stats_.pooled_buffers;
+                    bucket[i] = bucket.back();
+                    bucket.pop_back();
+                } else {
+                    ++i;
+                }
+            }
+            it = bucket.empty() ? buffers_.erase(it) : std::next(it);
+        }
+    }
+
+    FramePool::Stats FramePool::GetStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+}  // namespace ImageProcessor
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace ImageProcessor {
+
+// 按尺寸和类型复用图像缓冲区的对象池，ImageProcessor 与 CircleDetector 共用
+// Acquire 返回的 cv::Mat 与池共享引用计数，使用方释放最后一个引用后缓冲区自动回到池中，
+// 因此可以像普通 cv::Mat 一样传递、截取视图，无需显式归还
+// 需要新分配时顺带释放长时间没有被请求过的尺寸的空闲缓冲区，帧尺寸变化后池不会无限增长
+    class FramePool {
+    public:
+        // 统计信息，稳态下 allocations 不再增长
+        struct Stats {
+            uint64_t allocations = 0;     // 新分配的缓冲区数
+            uint64_t reuses = 0;          // 复用已有缓冲区的次数
+            uint64_t pooled_bytes = 0;    // 池中缓冲区总字节数
+            size_t pooled_buffers = 0;    // 池中缓冲区个数
+        };
+
+        // 进程内共享的池
+        static FramePool& Shared();
+
+        FramePool() = default;
+        FramePool(const FramePool&) = delete;
+        FramePool& operator=(const FramePool&) = delete;
+
+        // 取得一个 size x type 的缓冲区，内容未初始化（线程安全）
+        cv::Mat Acquire(cv::Size size, int type);
+
+        // 同上，且 mat 已是该尺寸和类型时直接保留，避免同一缓冲区在使用方和池之间来回
+        void Ensure(cv::Mat& mat, cv::Size size, int type);
+
+        // 释放池中当前未被使用的缓冲区
+        void Trim();
+
+        // 某个尺寸和类型连续这么多次 Acquire 没有被请求时，其空闲缓冲区在下一次新分配时释放
+        static constexpr uint64_t kIdleAcquires = 256;
+
+        Stats GetStats() const;
+
+    private:
+        using Key = std::tuple<int, int, int>;  // 行、列、类型
+
+        // 同一尺寸和类型的缓冲区
+        struct Bucket {
+            std::vector<cv::Mat> mats;
+            uint64_t last_acquire = 0;  // 最后一次被请求时的 Acquire 计数
+        };
+
+        // 释放 last_acquire 不晚于 before 的桶中的空闲缓冲区（调用方持有 mutex_）
+        void TrimLocked(uint64_t before);
+
+        mutable std::mutex mutex_;
+        std::map<Key, Bucket> buffers_;
+        uint64_t acquire_count_ = 0;  // 累计 Acquire 次数
+        Stats stats_;
+    };
+
+}  // namespace ImageProcessor
+
+#endif  // FRAME_POOL_H
\ No newline at end of file
@@ -0,0 +1,121 @@
+// 共享内存回放工具：把文件夹中相机写出的 Image_<编号>.png 按编号顺序解码后写入 SharedFrameRing，
+// 在没有相机的情况下测试 txma --shm 的整条流水线
+// 用法: txma_replay <文件夹> [--name <共享内存名>] [--fps N] [--slots N] [--gray] [--loop]
+//   --fps 0（默认）时不限速，环满时等待检测进程交还槽位；--gray 写入单通道帧（模拟黑白相机）
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "folder_watcher.h"
+#include "shared_frame_ring.h"
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    std::string folder_path;
+    std::string name = "txma_frames";
+    double fps = 0.0;
+    int slots = 8;
+    bool gray = false;
+    bool loop = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (arg == "--fps" && i + 1 < argc) {
+            fps = std::stod(argv[++i]);
+        } else if (arg == "--slots" && i + 1 < argc) {
+            slots = std::stoi(argv[++i]);
+        } else if (arg == "--gray") {
+            gray = true;
+        } else if (arg == "--loop") {
+            loop = true;
+        } else if (!arg.empty() && arg[0] != '-' && folder_path.empty()) {
+            folder_path = arg;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (folder_path.empty()) {
+        std::cerr << "Usage: txma_replay <folder> [--name <shm name>] [--fps N] [--slots N] [--gray] [--loop]"
+                  << std::endl;
+        return 1;
+    }
+
+    // 与 FolderWatcher 相同的文件名规则，按帧编号排序
+    std::vector<std::pair<int64_t, std::string>> files;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(folder_path, error)) {
+        int64_t number;
+        const std::string filename = entry.path().filename().string();
+        if (entry.is_regular_file() && ImageProcessor::FolderWatcher::ParseFrameNumber(filename, number)) {
+            files.emplace_back(number, entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty()) {
+        std::cerr << "No Image_<number>.png frames in " << folder_path << std::endl;
+        return 1;
+    }
+
+    const int flags = gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+    const cv::Mat first = cv::imread(files.front().second, flags);
+    if (first.empty()) {
+        std::cerr << "Unable to load image: " << files.front().second << std::endl;
+        return 1;
+    }
+
+    // 槽位按第一帧的尺寸分配，更大的帧跳过
+    ImageProcessor::SharedFrameRing ring;
+    const size_t frame_bytes = first.total() * first.elemSize();
+    if (!ring.Create(name, slots, frame_bytes)) {
+        std::cerr << "Unable to create shared memory ring: " << name << std::endl;
+        return 1;
+    }
+    std::cerr << "Replaying " << files.size() << " frames (" << first.cols << "x" << first.rows
+              << (gray ? " gray" : " BGR") << ") into '" << name << "', " << ring.SlotCount() << " slots" << std::endl;
+
+    const auto period = fps > 0.0 ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / fps)) : std::chrono::steady_clock::duration::zero();
+    const auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    uint64_t written = 0;
+    uint64_t skipped = 0;
+    do {
+        for (const auto& file : files) {
+            const cv::Mat frame = cv::imread(file.second, flags);
+            if (frame.empty() || frame.total() * frame.elemSize() > ring.SlotBytes()) {
+                std::cerr << "Skipping " << file.second << std::endl;
+                ++skipped;
+                continue;
+            }
+
+            if (period != std::chrono::steady_clock::duration::zero()) {
+                std::this_thread::sleep_until(next);
+                next += period;
+            }
+
+            const int64_t timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+            // 环满说明检测进程跟不上（或尚未启动），回放不丢帧，一直等到槽位交还
+            while (!ring.Write(frame, timestamp_us, 1000)) {
+                std::cerr << "Ring full, waiting for consumer..." << std::endl;
+            }
+            ++written;
+        }
+    } while (loop);
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Wrote " << written << " frames (" << skipped << " skipped) in " << seconds << " s, "
+              << (seconds > 0.0 ? written / seconds : 0.0) << " fps" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "frame_source.h"
+#include <chrono>
+#include <thread>
+
+namespace ImageProcessor {
+
+    namespace {
+
+        // 共享内存来源等待新帧（或生产者上线）时的轮询间隔
+        constexpr auto kRingPollInterval = std::chrono::microseconds(500);
+
+    }  // namespace
+
+    FolderFrameSource::FolderFrameSource(const std::string& folder_path, const ImageIngest::RawFormat& raw)
+            : folder_path_(folder_path), watcher_(folder_path, raw) {}
+
+    std::vector<SourceFrame> FolderFrameSource::ScanExisting(int64_t after_number) {
+        return ToFrames(watcher_.ScanExisting(after_number));
+    }
+
+    std::vector<SourceFrame> FolderFrameSource::WaitForFrames(int timeout_ms, int64_t after_number) {
+        return ToFrames(watcher_.WaitForFiles(timeout_ms, after_number));
+    }
+
+    std::vector<SourceFrame> FolderFrameSource::ToFrames(std::vector<WatchedFile> files) {
+        std::vector<SourceFrame> frames(files.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            frames[i].number = files[i].number;
+            frames[i].filename = std::move(files[i].filename);
+        }
+        return frames;
+    }
+
+    SharedMemoryFrameSource::SharedMemoryFrameSource(const std::string& name) : name_(name) {}
+
+    std::vector<SourceFrame> SharedMemoryFrameSource::ScanExisting(int64_t after_number) {
+        return WaitForFrames(0, after_number);
+    }
+
+    std::vector<SourceFrame> SharedMemoryFrameSource::WaitForFrames(int timeout_ms, int64_t after_number) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (true) {
+            // 旧环中未交还的帧由各自的租约持有，这里只断开连接；新环的序列号从 0 开始，编号接在已投递的帧之后
+            if (ring_ && ring_->Abandoned()) {
+                ring_.reset();
+                base_number_ = last_number_ + 1;
+            }
+            if (!ring_) {
+                auto ring = std::make_shared<SharedFrameRing>();
+                if (ring->Open(name_)) ring_ = std::move(ring);
+            }
+
+            std::vector<SourceFrame> frames = ReadAvailable(after_number);
+            if (!frames.empty() || std::chrono::steady_clock::now() >= deadline) return frames;
+            std::this_thread::sleep_for(kRingPollInterval);
+        }
+    }
+
+    std::vector<SourceFrame> SharedMemoryFrameSource::ReadAvailable(int64_t after_number) {
+        std::vector<SourceFrame> frames;
+        if (!ring_) return frames;
+
+        SharedFrameRing::FrameInfo info;
+        cv::Mat image;
+        while (ring_->TryRead(info, image)) {
+            SourceFrame frame;
+            frame.number = base_number_ + static_cast<int64_t>(info.sequence);
+            frame.filename = name_ + ":" + std::to_string(info.sequence);
+            frame.image = image;
+            // 租约同时持有环，环被替换后旧映射仍然有效，直到最后一个槽位交还
+            frame.lease = std::shared_ptr<void>(nullptr, [ring = ring_, sequence = info.sequence](void*) {
+                ring->Release(sequence);
+            });
+            last_number_ = frame.number;
+            // 水位以下的帧直接交还槽位
+            if (frame.number <= after_number) continue;
+            frames.push_back(std::move(frame));
+        }
+        return frames;
+    }
+
+}  // namespace ImageProcessor
\ No newline at end of file
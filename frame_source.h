@@ -0,0 +1,90 @@
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include "folder_watcher.h"
+#include "shared_frame_ring.h"
+
+namespace ImageProcessor {
+
+// 帧来源送入流水线的一帧
+    struct SourceFrame {
+        int64_t number = 0;             // 帧编号，流水线按编号去重和排序
+        std::string filename;           // 文件名（文件来源）或帧标识（内存来源）
+        cv::Mat image;                  // 已在内存中的全分辨率原始帧（零拷贝），为空时预处理阶段按 filename 读取文件
+        std::shared_ptr<void> lease;    // 保持 image 指向的内存有效，最后一个引用释放时交还给来源
+    };
+
+// 帧来源接口：采集阶段从这里取帧
+    class FrameSource {
+    public:
+        virtual ~FrameSource() = default;
+
+        // 启动补扫：列出编号大于 after_number 的已有帧，按编号排序
+        virtual std::vector<SourceFrame> ScanExisting(int64_t after_number) = 0;
+
+        // 等待编号大于 after_number 的新帧，最多等待 timeout_ms 毫秒，按编号排序；超时返回空列表
+        virtual std::vector<SourceFrame> WaitForFrames(int timeout_ms, int64_t after_number) = 0;
+
+        // 文件所在目录（读取失败时用于提示），内存来源为空
+        virtual std::string Folder() const = 0;
+
+        // 帧编号跨进程重启保持不变、可用已处理帧日志断点续传时返回 true
+        virtual bool Resumable() const = 0;
+
+        // 断点续传前检查帧计数是否已重置：编号不大于 watermark 的帧中有在 since 之后写入的，
+        // 返回其中最小的编号，否则返回 -1
+        virtual int64_t FindCounterReset(int64_t watermark, std::filesystem::file_time_type since) const = 0;
+    };
+
+// 文件夹来源：监视相机写出的 Image_<编号>.png（或未压缩的 .pgm / .ppm / .bmp / .raw），由预处理阶段读取
+    class FolderFrameSource : public FrameSource {
+    public:
+        explicit FolderFrameSource(const std::string& folder_path,
+                                   const ImageIngest::RawFormat& raw = ImageIngest::RawFormat());
+
+        std::vector<SourceFrame> ScanExisting(int64_t after_number) override;
+        std::vector<SourceFrame> WaitForFrames(int timeout_ms, int64_t after_number) override;
+        std::string Folder() const override { return folder_path_; }
+        bool Resumable() const override { return true; }
+        int64_t FindCounterReset(int64_t watermark, std::filesystem::file_time_type since) const override {
+            return watcher_.FindCounterReset(watermark, since);
+        }
+
+    private:
+        static std::vector<SourceFrame> ToFrames(std::vector<WatchedFile> files);
+
+        std::string folder_path_;
+        FolderWatcher watcher_;
+    };
+
+// 共享内存来源：从 SharedFrameRing 读取原始帧，cv::Mat 头直接指向共享内存，帧离开预处理后交还槽位
+// 生产者尚未创建环时每次等待中重试打开；生产者以不同规格重建环后自动切换到新环
+    class SharedMemoryFrameSource : public FrameSource {
+    public:
+        explicit SharedMemoryFrameSource(const std::string& name);
+
+        std::vector<SourceFrame> ScanExisting(int64_t after_number) override;
+        std::vector<SourceFrame> WaitForFrames(int timeout_ms, int64_t after_number) override;
+        std::string Folder() const override { return std::string(); }
+        bool Resumable() const override { return false; }
+        int64_t FindCounterReset(int64_t, std::filesystem::file_time_type) const override { return -1; }
+
+    private:
+        // 取出环中当前可读的所有帧
+        std::vector<SourceFrame> ReadAvailable(int64_t after_number);
+
+        std::string name_;                        // 共享内存对象名
+        std::shared_ptr<SharedFrameRing> ring_;   // 当前连接的环，未连接时为空；租约持有旧环直到槽位交还
+        int64_t base_number_ = 0;                 // 切换到新环时的编号偏移，保证编号单调递增
+        int64_t last_number_ = -1;                // 最近投递的帧编号
+    };
+
+}  // namespace ImageProcessor
+
+#endif  // FRAME_SOURCE_H
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "fused_gradient.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TXMA_GRADIENT_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TXMA_GRADIENT_NEON 1
+#endif
+
+namespace FusedGradient {
+
+    namespace {
+
+        // 每个线程复用的行缓冲
+        struct Workspace {
+            std::vector<uchar> gradient;    // 三行梯度环形缓冲
+            std::vector<uint16_t> sums;     // 当前输出行的纵向三行和，同样左右各留一个边界像素
+        };
+
+        thread_local Workspace workspace;
+
+        // BORDER_REFLECT_101 下标映射
+        inline int Reflect101(int i, int n) {
+            if (n == 1) return 0;
+            if (i < 0) return -i;
+            if (i >= n) return 2 * n - 2 - i;
+            return i;
+        }
+
+        // 3x3 Sobel 下 gx - gy = 2 * ((u[x] + u[x+1] + m[x+1]) - (m[x-1] + d[x-1] + d[x]))，
+        // u/m/d 为上/中/下三行；取绝对值并饱和到 255 即 convertScaleAbs 的结果
+        inline uchar GradientPixel(const uchar* up, const uchar* mid, const uchar* down, int x, int cols) {
+            const int left = Reflect101(x - 1, cols);
+            const int right = Reflect101(x + 1, cols);
+            const int diff = (up[x] + up[right] + mid[right]) - (mid[left] + down[left] + down[x]);
+            return static_cast<uchar>(std::min(2 * std::abs(diff), 255));
+        }
+
+        // 计算一行梯度差写入 out[0, cols)，内部像素用 SIMD，左右两端按边界映射单独计算
+        void GradientRow(const uchar* up, const uchar* mid, const uchar* down, uchar* out, int cols) {
+            int x = 1;
+#if defined(TXMA_GRADIENT_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            auto load = [](const uchar* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+            for (; x + 17 <= cols; x += 16) {
+                const __m128i u0 = load(up + x), u1 = load(up + x + 1), m1 = load(mid + x + 1);
+                const __m128i m0 = load(mid + x - 1), d0 = load(down + x - 1), d1 = load(down + x);
+                const auto half = [&](auto unpack) {
+                    const __m128i positive = _mm_add_epi16(_mm_add_epi16(unpack(u0, zero), unpack(u1, zero)),
+                                                           unpack(m1, zero));
+                    const __m128i negative = _mm_add_epi16(_mm_add_epi16(unpack(m0, zero), unpack(d0, zero)),
+                                                           unpack(d1, zero));
+                    const __m128i diff = _mm_sub_epi16(positive, negative);
+                    const __m128i magnitude = _mm_max_epi16(diff, _mm_sub_epi16(zero, diff));
+                    return _mm_add_epi16(magnitude, magnitude);
+                };
+                const __m128i lo = half([](__m128i a, __m128i b) { return _mm_unpacklo_epi8(a, b); });
+                const __m128i hi = half([](__m128i a, __m128i b) { return _mm_unpackhi_epi8(a, b); });
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(lo, hi));
+            }
+#elif defined(TXMA_GRADIENT_NEON)
+            for (; x + 9 <= cols; x += 8) {
+                const uint16x8_t positive = vaddw_u8(vaddl_u8(vld1_u8(up + x), vld1_u8(up + x + 1)),
+                                                     vld1_u8(mid + x + 1));
+                const uint16x8_t negative = vaddw_u8(vaddl_u8(vld1_u8(mid + x - 1), vld1_u8(down + x - 1)),
+                                                     vld1_u8(down + x));
+                const uint16x8_t magnitude = vabdq_u16(positive, negative);
+                vst1_u8(out + x, vqmovn_u16(vaddq_u16(magnitude, magnitude)));
+            }
+#endif
+            for (; x < cols - 1; ++x) {
+                out[x] = GradientPixel(up, mid, down, x, cols);
+            }
+            out[0] = GradientPixel(up, mid, down, 0, cols);
+            if (cols > 1) out[cols - 1] = GradientPixel(up, mid, down, cols - 1, cols);
+        }
+
+        // 三行梯度纵向求和后横向求和，与 limit 比较输出 0/255；sums 与梯度行一样左右各留一个边界像素
+        void ThresholdRow(const uchar* g0, const uchar* g1, const uchar* g2, uint16_t* sums, uchar* out,
+                          int cols, int limit) {
+            int x = 0;
+#if defined(TXMA_GRADIENT_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            for (; x + 16 <= cols; x += 16) {
+                auto load = [&](const uchar* row) {
+                    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+                };
+                const __m128i a = load(g0), b = load(g1), c = load(g2);
+                const __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+                                                 _mm_unpacklo_epi8(c, zero));
+                const __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+                                                 _mm_unpackhi_epi8(c, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 1 + x), lo);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 9 + x), hi);
+            }
+#elif defined(TXMA_GRADIENT_NEON)
+            for (; x + 8 <= cols; x += 8) {
+                vst1q_u16(sums + 1 + x, vaddw_u8(vaddl_u8(vld1_u8(g0 + x), vld1_u8(g1 + x)), vld1_u8(g2 + x)));
+            }
+#endif
+            for (; x < cols; ++x) {
+                sums[1 + x] = static_cast<uint16_t>(g0[x] + g1[x] + g2[x]);
+            }
+            sums[0] = sums[1 + Reflect101(-1, cols)];
+            sums[cols + 1] = sums[1 + Reflect101(cols, cols)];
+
+            x = 0;
+#if defined(TXMA_GRADIENT_SSE2)
+            // 和最大 9 * 255，有符号 16 位比较不会溢出
+            const __m128i threshold = _mm_set1_epi16(static_cast<short>(limit));
+            auto load16 = [](const uint16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+            for (; x + 16 <= cols; x += 16) {
+                const __m128i lo = _mm_add_epi16(_mm_add_epi16(load16(sums + x), load16(sums + x + 1)),
+                                                 load16(sums + x + 2));
+                const __m128i hi = _mm_add_epi16(_mm_add_epi16(load16(sums + x + 8), load16(sums + x + 9)),
+                                                 load16(sums + x + 10));
+                const __m128i mask = _mm_packs_epi16(_mm_cmpgt_epi16(lo, threshold), _mm_cmpgt_epi16(hi, threshold));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), mask);
+            }
+#elif defined(TXMA_GRADIENT_NEON)
+            // 与 SSE2 相同用有符号比较：threshold 为 -1 时 limit 为负，无符号比较会回绕成全 0
+            const int16x8_t threshold = vdupq_n_s16(static_cast<int16_t>(limit));
+            for (; x + 8 <= cols; x += 8) {
+                const uint16x8_t sum = vaddq_u16(vaddq_u16(vld1q_u16(sums + x), vld1q_u16(sums + x + 1)),
+                                                 vld1q_u16(sums + x + 2));
+                vst1_u8(out + x, vmovn_u16(vcgtq_s16(vreinterpretq_s16_u16(sum), threshold)));
+            }
+#endif
+            for (; x < cols; ++x) {
+                out[x] = sums[x] + sums[x + 1] + sums[x + 2] > limit ? 255 : 0;
+            }
+        }
+
+    }  // namespace
+
+    void GradientThreshold(const cv::Mat& gray, cv::Mat& binary, int threshold) {
+        CV_Assert(gray.type() == CV_8UC1);
+        TXMA_TRACE_SCOPE("FusedGradient.GradientThreshold");
+        const int rows = gray.rows;
+        const int cols = gray.cols;
+        binary.create(rows, cols, CV_8UC1);
+        if (rows == 0 || cols == 0) return;
+
+        // round(sum / 9) > threshold  <=>  sum > 9 * threshold + 4
+        const int limit = 9 * std::clamp(threshold, -1, 255) + 4;
+
+        Workspace& ws = workspace;
+        ws.gradient.resize(static_cast<size_t>(cols) * 3);
+        ws.sums.resize(static_cast<size_t>(cols) + 2);
+        auto gradient_row = [&](int y) { return ws.gradient.data() + static_cast<size_t>(y % 3) * cols; };
+
+        // 梯度行按需计算，环形缓冲中始终保留输出行上下相邻的三行
+        int computed = -1;
+        for (int y = 0; y < rows; ++y) {
+            for (const int last = std::min(y + 1, rows - 1); computed < last;) {
+                ++computed;
+                GradientRow(gray.ptr<uchar>(Reflect101(computed - 1, rows)), gray.ptr<uchar>(computed),
+                            gray.ptr<uchar>(Reflect101(computed + 1, rows)), gradient_row(computed), cols);
+            }
+            ThresholdRow(gradient_row(Reflect101(y - 1, rows)), gradient_row(y),
+                         gradient_row(Reflect101(y + 1, rows)), ws.sums.data(), binary.ptr<uchar>(y), cols, limit);
+        }
+    }
+
+}  // namespace FusedGradient
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef FUSED_GRADIENT_H
+#define FUSED_GRADIENT_H
+
+#include <opencv2/opencv.hpp>
+
+namespace FusedGradient {
+
+    // 一次逐行扫描完成条形码增强与二值化，对应 OpenCV 链路（边界均为 BORDER_REFLECT_101）
+    //   Sobel(dx, CV_16S) / Sobel(dy, CV_16S) -> subtract -> convertScaleAbs -> blur(3x3) -> threshold(BINARY)
+    // 结果与该链路逐像素一致：均值四舍五入后大于 threshold 等价于 3x3 和大于 9 * threshold + 4，不做除法
+    // 只保留最近三行梯度和一行纵向和，不生成 CV_16S 中间图像；gray 必须为 CV_8UC1，尺寸不变时复用 binary 的缓冲区
+    void GradientThreshold(const cv::Mat& gray, cv::Mat& binary, int threshold);
+
+}  // namespace FusedGradient
+
+#endif  // FUSED_GRADIENT_H
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "fused_preprocess.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TXMA_FUSED_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TXMA_FUSED_NEON 1
+#endif
+
+namespace FusedPreprocess {
+
+    namespace {
+
+        // 与 cv::cvtColor(COLOR_BGR2GRAY) 的 8 位路径相同的定点系数（15 位，三者之和为 1 << 15）
+        constexpr int kGrayShift = 15;
+        constexpr int kGrayB = 3735;
+        constexpr int kGrayG = 19235;
+        constexpr int kGrayR = 9798;
+
+        // 9 个数的中值排序网络（19 次比较交换），SIMD 与标量路径使用同一网络
+        template <typename T, typename Min, typename Max>
+        inline T Median9(T p0, T p1, T p2, T p3, T p4, T p5, T p6, T p7, T p8, Min vmin, Max vmax) {
+            auto sort = [&](T& a, T& b) {
+                const T lo = vmin(a, b);
+                b = vmax(a, b);
+                a = lo;
+            };
+            sort(p1, p2); sort(p4, p5); sort(p7, p8);
+            sort(p0, p1); sort(p3, p4); sort(p6, p7);
+            sort(p1, p2); sort(p4, p5); sort(p7, p8);
+            sort(p0, p3); sort(p5, p8); sort(p4, p7);
+            sort(p3, p6); sort(p1, p4); sort(p2, p5);
+            sort(p4, p7); sort(p4, p2); sort(p6, p4);
+            sort(p4, p2);
+            return p4;
+        }
+
+        // 对三行已做左右边界复制的灰度行（宽 cols + 2）求 3x3 中值，输出 cols 个像素
+        void MedianRow(const uchar* r0, const uchar* r1, const uchar* r2, uchar* dst, int cols) {
+            int x = 0;
+#if defined(TXMA_FUSED_SSE2)
+            const auto vmin = [](__m128i a, __m128i b) { return _mm_min_epu8(a, b); };
+            const auto vmax = [](__m128i a, __m128i b) { return _mm_max_epu8(a, b); };
+            auto load = [](const uchar* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+            for (; x + 16 <= cols; x += 16) {
+                const __m128i m = Median9(load(r0 + x), load(r0 + x + 1), load(r0 + x + 2),
+                                          load(r1 + x), load(r1 + x + 1), load(r1 + x + 2),
+                                          load(r2 + x), load(r2 + x + 1), load(r2 + x + 2), vmin, vmax);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), m);
+            }
+#elif defined(TXMA_FUSED_NEON)
+            const auto vmin = [](uint8x16_t a, uint8x16_t b) { return vminq_u8(a, b); };
+            const auto vmax = [](uint8x16_t a, uint8x16_t b) { return vmaxq_u8(a, b); };
+            for (; x + 16 <= cols; x += 16) {
+                const uint8x16_t m = Median9(vld1q_u8(r0 + x), vld1q_u8(r0 + x + 1), vld1q_u8(r0 + x + 2),
+                                             vld1q_u8(r1 + x), vld1q_u8(r1 + x + 1), vld1q_u8(r1 + x + 2),
+                                             vld1q_u8(r2 + x), vld1q_u8(r2 + x + 1), vld1q_u8(r2 + x + 2),
+                                             vmin, vmax);
+                vst1q_u8(dst + x, m);
+            }
+#endif
+            const auto smin = [](uchar a, uchar b) { return std::min(a, b); };
+            const auto smax = [](uchar a, uchar b) { return std::max(a, b); };
+            for (; x < cols; ++x) {
+                dst[x] = Median9(r0[x], r0[x + 1], r0[x + 2], r1[x], r1[x + 1], r1[x + 2],
+                                 r2[x], r2[x + 1], r2[x + 2], smin, smax);
+            }
+        }
+
+        // 每个线程复用的行缓冲区
+        struct Workspace {
+            std::vector<uint16_t> column_sums;  // factor 行源图像逐字节纵向求和，factor <= 16 时不会溢出
+            std::vector<uint16_t> sums;         // 横向滑动求和结果，每隔 factor * 3 项为一个块的 BGR 和
+            std::vector<uchar> gray_rows;       // 三行带边界的灰度环形缓冲，每行 cols + 2
+        };
+
+        // factor 行源图像逐字节纵向求和，在寄存器中累加后一次写出
+        void SumRows(const uchar* block, size_t src_step, int factor, uint16_t* column_sums, int n) {
+            int i = 0;
+#if defined(TXMA_FUSED_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 16 <= n; i += 16) {
+                __m128i lo = zero, hi = zero;
+                const uchar* src = block + i;
+                for (int k = 0; k < factor; ++k, src += src_step) {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                    lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+                    hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(column_sums + i), lo);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(column_sums + i + 8), hi);
+            }
+#elif defined(TXMA_FUSED_NEON)
+            for (; i + 16 <= n; i += 16) {
+                uint16x8_t lo = vdupq_n_u16(0), hi = vdupq_n_u16(0);
+                const uchar* src = block + i;
+                for (int k = 0; k < factor; ++k, src += src_step) {
+                    const uint8x16_t v = vld1q_u8(src);
+                    lo = vaddw_u8(lo, vget_low_u8(v));
+                    hi = vaddw_u8(hi, vget_high_u8(v));
+                }
+                vst1q_u16(column_sums + i, lo);
+                vst1q_u16(column_sums + i + 8, hi);
+            }
+#endif
+            for (; i < n; ++i) {
+                unsigned int sum = 0;
+                const uchar* src = block + i;
+                for (int k = 0; k < factor; ++k, src += src_step) sum += *src;
+                column_sums[i] = static_cast<uint16_t>(sum);
+            }
+        }
+
+        // 横向滑动求和：window_sums[j] = column_sums[j] + column_sums[j + 3] + ... 共 factor 项
+        // 输出列 x 的通道 c 即 window_sums[x * factor * 3 + c]
+        void SumColumns(const uint16_t* column_sums, uint16_t* window_sums, int factor, int n) {
+            const int count = n - 3 * (factor - 1);
+            int j = 0;
+#if defined(TXMA_FUSED_SSE2)
+            for (; j + 8 <= count; j += 8) {
+                __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column_sums + j));
+                for (int k = 1; k < factor; ++k) {
+                    sum = _mm_add_epi16(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(column_sums + j + 3 * k)));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(window_sums + j), sum);
+            }
+#elif defined(TXMA_FUSED_NEON)
+            for (; j + 8 <= count; j += 8) {
+                uint16x8_t sum = vld1q_u16(column_sums + j);
+                for (int k = 1; k < factor; ++k) sum = vaddq_u16(sum, vld1q_u16(column_sums + j + 3 * k));
+                vst1q_u16(window_sums + j, sum);
+            }
+#endif
+            for (; j < count; ++j) {
+                unsigned int sum = 0;
+                for (int k = 0; k < factor; ++k) sum += column_sums[j + 3 * k];
+                window_sums[j] = static_cast<uint16_t>(sum);
+            }
+        }
+
+        // 按行指针处理，输出行数 src_rows / factor
+        void DownscaleGrayMedianRows(const uchar* src, size_t src_step, int src_cols, int src_rows, int factor,
+                                     uchar* gray, size_t gray_step, uchar* color, size_t color_step) {
+            const int cols = src_cols / factor;
+            const int rows = src_rows / factor;
+            if (cols <= 0 || rows <= 0) return;
+
+            thread_local Workspace workspace;
+            std::vector<uint16_t>& column_sums = workspace.column_sums;
+            std::vector<uint16_t>& sums = workspace.sums;
+            std::vector<uchar>& ring = workspace.gray_rows;
+            const int row_bytes = cols * factor * 3;
+            column_sums.resize(row_bytes);
+            sums.resize(row_bytes);
+            ring.resize(static_cast<size_t>(cols + 2) * 3);
+            auto ring_row = [&](int y) { return ring.data() + static_cast<size_t>(y % 3) * (cols + 2); };
+
+            // 块平均的除法改为乘以倒数：和小于 2^16、面积不超过 256 时结果与整数除法完全一致
+            const unsigned int area = static_cast<unsigned int>(factor * factor);
+            const uint64_t reciprocal = ((uint64_t(1) << 32) + area - 1) / area;
+            auto average = [&](unsigned int sum) {
+                return static_cast<unsigned int>(((sum + area / 2) * reciprocal) >> 32);
+            };
+            for (int y = 0; y < rows; ++y) {
+                // 纵向累加 factor 行源图像，再横向每 factor 个像素归入同一个输出列
+                SumRows(src + static_cast<size_t>(y * factor) * src_step, src_step, factor,
+                        column_sums.data(), row_bytes);
+                SumColumns(column_sums.data(), sums.data(), factor, row_bytes);
+
+                // 块平均后转换为灰度，写入环形缓冲并复制左右边界
+                uchar* line = ring_row(y);
+                uchar* color_row = color ? color + static_cast<size_t>(y) * color_step : nullptr;
+                for (int x = 0; x < cols; ++x) {
+                    const uint16_t* block_sum = sums.data() + static_cast<size_t>(x) * factor * 3;
+                    const unsigned int b = average(block_sum[0]);
+                    const unsigned int g = average(block_sum[1]);
+                    const unsigned int r = average(block_sum[2]);
+                    line[x + 1] = static_cast<uchar>((b * kGrayB + g * kGrayG + r * kGrayR +
+                                                      (1 << (kGrayShift - 1))) >> kGrayShift);
+                    if (color_row) {
+                        color_row[x * 3] = static_cast<uchar>(b);
+                        color_row[x * 3 + 1] = static_cast<uchar>(g);
+                        color_row[x * 3 + 2] = static_cast<uchar>(r);
+                    }
+                }
+                line[0] = line[1];
+                line[cols + 1] = line[cols];
+
+                // 灰度行 y 就绪后输出中值行 y - 1，上边界复制第 0 行
+                if (y >= 1) {
+                    MedianRow(ring_row(std::max(y - 2, 0)), ring_row(y - 1), line,
+                              gray + static_cast<size_t>(y - 1) * gray_step, cols);
+                }
+            }
+
+            // 最后一行的下边界复制自身
+            const uchar* last = ring_row(rows - 1);
+            MedianRow(ring_row(std::max(rows - 2, 0)), last, last,
+                      gray + static_cast<size_t>(rows - 1) * gray_step, cols);
+        }
+
+    }  // namespace
+
+    void DownscaleGrayMedian(const cv::Mat& bgr, int factor, cv::Mat& gray, cv::Mat* color) {
+        TXMA_TRACE_SCOPE("FusedPreprocess.DownscaleGrayMedian");
+        CV_Assert(bgr.type() == CV_8UC3 && factor >= 1 && factor <= kMaxFactor);
+
+        const cv::Size size(bgr.cols / factor, bgr.rows / factor);
+        gray.create(size, CV_8UC1);
+        if (color) color->create(size, CV_8UC3);
+        if (size.width <= 0 || size.height <= 0) return;
+
+        DownscaleGrayMedianRows(bgr.ptr<uchar>(), bgr.step, bgr.cols, bgr.rows, factor,
+                                gray.ptr<uchar>(), gray.step,
+                                color ? color->ptr<uchar>() : nullptr, color ? color->step : 0);
+    }
+
+}  // namespace FusedPreprocess
\ No newline at end of file
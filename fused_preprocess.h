@@ -0,0 +1,22 @@
+#ifndef FUSED_PREPROCESS_H
+#define FUSED_PREPROCESS_H
+
+#include <opencv2/opencv.hpp>
+
+namespace FusedPreprocess {
+
+    // 支持的最大降采样倍数：块和以 16 位累加，16 x 16 x 255 不溢出
+    constexpr int kMaxFactor = 16;
+
+    // 一次扫描完成 块平均降采样 + 灰度转换 + 3x3 中值滤波（边界复制），对应 OpenCV 链路
+    //   裁掉不足一个块的边缘 -> resize(INTER_AREA) -> cvtColor(BGR2GRAY) -> medianBlur(3)
+    // 块平均恰为 .5 时本函数向上舍入（与倍数为 2 时的 INTER_AREA 相同）；倍数为 4 及以上的偶数时 INTER_AREA
+    // 向偶数舍入，只有这些块的结果可能比本函数小 1，其余像素逐一相同；txma_bench 启动时按整块平均逐像素检查
+    // 每 factor 行源图像产生一行灰度，只保留最近三行灰度做中值，不生成全尺寸中间图像
+    // bgr 必须为 CV_8UC3，factor 在 [1, kMaxFactor] 内；输出尺寸为 (cols / factor, rows / factor)，尺寸不变时复用 gray 的缓冲区
+    // color 非空时同时输出块平均后的彩色图（用于可视化），不增加额外扫描
+    void DownscaleGrayMedian(const cv::Mat& bgr, int factor, cv::Mat& gray, cv::Mat* color = nullptr);
+
+}  // namespace FusedPreprocess
+
+#endif  // FUSED_PREPROCESS_H
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "image_ingest.h"
+#include "frame_pool.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#ifdef TXMA_WITH_LIBPNG
+#include <csetjmp>
+#include <png.h>
+#endif
+
+namespace ImageIngest {
+
+    namespace {
+
+        // 与 cv::cvtColor(COLOR_BGR2GRAY) 的 8 位路径相同的定点系数（15 位，三者之和为 1 << 15）
+        constexpr int kGrayShift = 15;
+        constexpr int kGrayB = 3735;
+        constexpr int kGrayG = 19235;
+        constexpr int kGrayR = 9798;
+
+        // 面积插值降采样；rgb 为 true 时 src 的通道顺序为 RGB，bottom_up 为 true 时 src 的行自下而上存放
+        // 自下而上存放时在降采样后的小图上翻转，面积插值对行序对称，结果与先翻转再降采样一致（舍入误差 1 以内）
+        cv::Mat DownscaleView(const cv::Mat& src, int factor, bool grayscale, cv::Mat* full_gray,
+                              bool rgb, bool bottom_up) {
+            if (src.empty() || (src.type() != CV_8UC1 && src.type() != CV_8UC3)) return cv::Mat();
+            if (factor < 1) factor = 1;
+            ImageProcessor::FramePool& pool = ImageProcessor::FramePool::Shared();
+            const bool color = src.channels() == 3;
+            if (full_gray) {
+                TXMA_TRACE_SCOPE("ImageIngest.cvtColorFull");
+                pool.Ensure(*full_gray, src.size(), CV_8UC1);
+                if (color) {
+                    cv::cvtColor(src, *full_gray, rgb ? cv::COLOR_RGB2GRAY : cv::COLOR_BGR2GRAY);
+                } else {
+                    src.copyTo(*full_gray);
+                }
+                if (bottom_up) cv::flip(*full_gray, *full_gray, 0);
+            }
+
+            const cv::Size size(src.cols / factor, src.rows / factor);
+            if (size.width <= 0 || size.height <= 0) return cv::Mat();
+            cv::Mat resized = pool.Acquire(size, src.type());
+            {
+                TXMA_TRACE_SCOPE("ImageIngest.resize");
+                // 先裁掉右侧和底部不足一个块的像素（自下而上存放时是存储区开头的几行），面积插值即为整块平均，
+                // 与逐行解码路径、融合预处理一致；不裁剪时 INTER_AREA 按非整数倍率插值，结果整体偏移
+                const int crop_rows = size.height * factor;
+                const cv::Mat cropped = src(cv::Rect(0, bottom_up ? src.rows - crop_rows : 0, size.width * factor,
+                                                     crop_rows));
+                cv::resize(cropped, resized, size, 0, 0, cv::INTER_AREA);
+                if (bottom_up) cv::flip(resized, resized, 0);
+            }
+            if (grayscale == !color && !(rgb && color)) return resized;
+
+            TXMA_TRACE_SCOPE("ImageIngest.cvtColor");
+            cv::Mat converted = pool.Acquire(size, grayscale ? CV_8UC1 : CV_8UC3);
+            const int code = !color ? cv::COLOR_GRAY2BGR
+                                    : grayscale ? (rgb ? cv::COLOR_RGB2GRAY : cv::COLOR_BGR2GRAY) : cv::COLOR_RGB2BGR;
+            cv::cvtColor(resized, converted, code);
+            return converted;
+        }
+
+        // 通用路径：完整解码后用面积插值降采样
+        cv::Mat ReadWithOpenCV(const std::string& image_path, int factor, bool grayscale, cv::Mat* full_gray) {
+            cv::Mat src;
+            {
+                TXMA_TRACE_SCOPE("ImageIngest.imread");
+                src = cv::imread(image_path, cv::IMREAD_COLOR);
+            }
+            return DownscaleView(src, factor, grayscale, full_gray, false, false);
+        }
+
+#ifdef TXMA_WITH_LIBPNG
+        // 逐行解码 PNG：每读入 factor 行累加一次块和，输出一行降采样结果
+        // 隔行扫描的 PNG 无法逐行解码，返回 false 交给通用路径
+        bool ReadPngDownscaled(const std::string& image_path, int factor, bool grayscale, cv::Mat& output,
+                               cv::Mat* full_gray) {
+            TXMA_TRACE_SCOPE("ImageIngest.DecodePngDownscaled");
+            FILE* file = std::fopen(image_path.c_str(), "rb");
+            if (!file) return false;
+
+            png_byte signature[8];
+            if (std::fread(signature, 1, sizeof(signature), file) != sizeof(signature) ||
+                png_sig_cmp(signature, 0, sizeof(signature)) != 0) {
+                std::fclose(file);
+                return false;
+            }
+
+            png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+            png_infop info = png ? png_create_info_struct(png) : nullptr;
+            if (!info) {
+                png_destroy_read_struct(&png, nullptr, nullptr);
+                std::fclose(file);
+                return false;
+            }
+
+            // 第一段：读取文件头，此时还没有需要析构的局部对象
+            if (setjmp(png_jmpbuf(png))) {
+                png_destroy_read_struct(&png, &info, nullptr);
+                std::fclose(file);
+                return false;
+            }
+
+            png_init_io(png, file);
+            png_set_sig_bytes(png, sizeof(signature));
+            png_read_info(png, info);
+
+            if (png_get_interlace_type(png, info) != PNG_INTERLACE_NONE) {
+                png_destroy_read_struct(&png, &info, nullptr);
+                std::fclose(file);
+                return false;
+            }
+
+            // 统一转换为 8 位 BGR，调色板/低位深/透明通道在 libpng 内部展开
+            png_set_expand(png);
+            png_set_strip_16(png);
+            png_set_strip_alpha(png);
+            png_set_gray_to_rgb(png);
+            png_set_bgr(png);
+            png_read_update_info(png, info);
+
+            const int width = static_cast<int>(png_get_image_width(png, info));
+            const int height = static_cast<int>(png_get_image_height(png, info));
+            const int out_cols = width / factor;
+            const int out_rows = height / factor;
+            if (out_cols <= 0 || out_rows <= 0) {
+                png_destroy_read_struct(&png, &info, nullptr);
+                std::fclose(file);
+                return false;
+            }
+
+            // 第二段：缓冲区在尺寸已知后一次分配，之后不再改变大小，再设置跳转点；
+            // longjmp 回来时它们的内部指针仍然有效，可以正常析构
+            std::vector<png_byte> row(png_get_rowbytes(png, info));
+            std::vector<unsigned int> sums(static_cast<size_t>(out_cols) * 3, 0);
+            ImageProcessor::FramePool& pool = ImageProcessor::FramePool::Shared();
+            output = pool.Acquire(cv::Size(out_cols, out_rows), grayscale ? CV_8UC1 : CV_8UC3);
+            if (full_gray) pool.Ensure(*full_gray, cv::Size(out_cols * factor, out_rows * factor), CV_8UC1);
+            if (setjmp(png_jmpbuf(png))) {
+                // 截断或损坏的 PNG 在逐行解码中途出错
+                png_destroy_read_struct(&png, &info, nullptr);
+                std::fclose(file);
+                output.release();
+                if (full_gray) full_gray->release();
+                return false;
+            }
+
+            const unsigned int area = static_cast<unsigned int>(factor * factor);
+            for (int y = 0; y < out_rows * factor; ++y) {
+                png_read_row(png, row.data(), nullptr);
+
+                // 全分辨率灰度行（与降采样输出覆盖同一区域）
+                if (full_gray) {
+                    const png_byte* src = row.data();
+                    uchar* gray = full_gray->ptr<uchar>(y);
+                    for (int x = 0; x < out_cols * factor; ++x, src += 3) {
+                        gray[x] = static_cast<uchar>((src[0] * kGrayB + src[1] * kGrayG + src[2] * kGrayR +
+                                                      (1 << (kGrayShift - 1))) >> kGrayShift);
+                    }
+                }
+
+                // 横向累加：每 factor 个像素归入同一个输出列
+                const png_byte* pixel = row.data();
+                for (int x = 0; x < out_cols; ++x) {
+                    unsigned int b = 0, g = 0, r = 0;
+                    for (int k = 0; k < factor; ++k, pixel += 3) {
+                        b += pixel[0];
+                        g += pixel[1];
+                        r += pixel[2];
+                    }
+                    sums[x * 3] += b;
+                    sums[x * 3 + 1] += g;
+                    sums[x * 3 + 2] += r;
+                }
+
+                if ((y + 1) % factor != 0) continue;
+
+                // 纵向凑满 factor 行后输出一行块平均结果
+                uchar* out = output.ptr<uchar>(y / factor);
+                for (int x = 0; x < out_cols; ++x) {
+                    const unsigned int b = (sums[x * 3] + area / 2) / area;
+                    const unsigned int g = (sums[x * 3 + 1] + area / 2) / area;
+                    const unsigned int r = (sums[x * 3 + 2] + area / 2) / area;
+                    if (grayscale) {
+                        out[x] = static_cast<uchar>((b * kGrayB + g * kGrayG + r * kGrayR +
+                                                     (1 << (kGrayShift - 1))) >> kGrayShift);
+                    } else {
+                        out[x * 3] = static_cast<uchar>(b);
+                        out[x * 3 + 1] = static_cast<uchar>(g);
+                        out[x * 3 + 2] = static_cast<uchar>(r);
+                    }
+                }
+                std::fill(sums.begin(), sums.end(), 0u);
+            }
+
+            // 剩余不足 factor 的行被丢弃，与 cols / factor 的截断一致，无需继续解码
+            png_destroy_read_struct(&png, &info, nullptr);
+            std::fclose(file);
+            return true;
+        }
+#endif
+
+    }  // namespace
+
+    cv::Mat Downscale(const cv::Mat& src, int factor, bool grayscale, cv::Mat* full_gray) {
+        return DownscaleView(src, factor, grayscale, full_gray, false, false);
+    }
+
+    cv::Mat ReadDownscaled(const std::string& image_path, int factor, bool grayscale, cv::Mat* full_gray,
+                           const RawFormat& raw) {
+        if (factor < 1) factor = 1;
+
+        // 未压缩格式：映射文件后直接在页缓存上降采样，不读取拷贝、不解码，返回前解除映射
+        if (IsUncompressedImage(image_path)) {
+            MappedImage mapped;
+            if (MapImage(image_path, raw, mapped)) {
+                TXMA_TRACE_SCOPE("ImageIngest.DownscaleMapped");
+                return DownscaleView(mapped.pixels, factor, grayscale, full_gray, mapped.rgb, mapped.bottom_up);
+            }
+        }
+
+#ifdef TXMA_WITH_LIBPNG
+        cv::Mat output;
+        if (ReadPngDownscaled(image_path, factor, grayscale, output, full_gray)) {
+            return output;
+        }
+#endif
+        return ReadWithOpenCV(image_path, factor, grayscale, full_gray);
+    }
+
+}  // namespace ImageIngest
\ No newline at end of file
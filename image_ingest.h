@@ -0,0 +1,26 @@
+#ifndef IMAGE_INGEST_H
+#define IMAGE_INGEST_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "mapped_image.h"
+
+namespace ImageIngest {
+
+    // 读取图像并按 factor 做块平均降采样，输出尺寸为 (cols / factor, rows / factor)，右侧和底部不足一个块的像素被丢弃
+    // PNG 逐行解码、边解码边降采样，不生成全分辨率图像；grayscale 为 true 时直接输出灰度图
+    // RAW / PGM / PPM / BMP 映射文件后直接在映射的像素上降采样（.raw 按 raw 解释，未设置时读取失败）
+    // full_gray 非空时额外输出全分辨率灰度图（供亚像素精化），在同一次解码中生成
+    // 输出缓冲区取自 ImageProcessor::FramePool，同尺寸的连续帧不再分配内存
+    // 读取失败返回空图像
+    cv::Mat ReadDownscaled(const std::string& image_path, int factor, bool grayscale,
+                           cv::Mat* full_gray = nullptr, const RawFormat& raw = RawFormat());
+
+    // 对已在内存中的全分辨率帧（CV_8UC1 或 BGR 的 CV_8UC3，可以是共享内存上的零拷贝视图）做同样的降采样
+    // 输出不引用 src，返回后即可交还 src 所在的内存；灰度帧在 grayscale 为 false 时展开为 BGR
+    // 类型不支持时返回空图像
+    cv::Mat Downscale(const cv::Mat& src, int factor, bool grayscale, cv::Mat* full_gray = nullptr);
+
+}  // namespace ImageIngest
+
+#endif  // IMAGE_INGEST_H
\ No newline at end of file
@@ -1,96 +1,405 @@
 #include "image_processor.h"
-#include <filesystem>
+#include "circle_text.h"
+#include "frame_pool.h"
+#include "image_ingest.h"
+#include "subpixel_refine.h"
+#include "trace.h"
 #include <algorithm>
 #include <chrono>
-#include <thread>
+#include <csignal>
+#include <filesystem>
 #include <iostream>
 
-namespace fs = std::filesystem;
-
 namespace ImageProcessor {
 
+    namespace {
+
+        // 无新结果时等待的最长时间，超时后打印监视状态
+        constexpr int kIdleTimeoutMs = 1000;
+
+        // 采集线程等待新文件的超时，决定响应停止请求的延迟
+        constexpr int kWatchTimeoutMs = 200;
+
+        // 相机图像降采样倍数（生产预处理策略）
+        constexpr int kDownscaleFactor = ProductionPreprocess::downscale();
+
+        // 生产检测参数，与 ProductionCircleDetector 相同
+        const CircleDetectionParams kDetectionParams;
+
+        // 等待按键时的轮询间隔，期间检查停止信号
+        constexpr int kKeyPollMs = 100;
+
+        // SIGINT/SIGTERM 到达标志，信号处理函数中只做无锁原子写
+        std::atomic<bool> g_stop_signal{false};
+
+        void HandleStopSignal(int) {
+            g_stop_signal = true;
+        }
+
+        // 队列空/满时的退避等待：先让出时间片，连续失败后短暂休眠
+        void Backoff(int& attempts) {
+            if (++attempts < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+        }
+
+    }  // namespace
+
     ImageProcessor::ImageProcessor(const std::string& folder_path)
-            : folder_path_(folder_path) {}
+            : ImageProcessor(folder_path, PipelineOptions()) {}
+
+    ImageProcessor::ImageProcessor(const std::string& folder_path, const PipelineOptions& options)
+            : ImageProcessor(std::make_unique<FolderFrameSource>(folder_path, options.raw_format), options) {}
+
+    ImageProcessor::ImageProcessor(std::unique_ptr<FrameSource> source, const PipelineOptions& options)
+            : source_(std::move(source)),
+              folder_path_(source_->Folder()),
+              options_(options),
+              ingest_queue_(options.queue_capacity),
+              detect_queue_(options.queue_capacity),
+              output_queue_(options.queue_capacity) {
+        options_.preprocess_workers = std::max(1, options_.preprocess_workers);
+        options_.detection_workers = std::max(1, options_.detection_workers);
+        if (options_.track_circles) {
+            // 跟踪以上一帧的结果为参考，多个线程并发时参考帧取决于完成顺序，结果不可复现；
+            // 预处理和检测各用一个线程，帧按顺序号依次到达检测线程，跟踪状态严格按帧顺序推进
+            if (options_.preprocess_workers > 1 || options_.detection_workers > 1) {
+                std::cerr << "Circle tracking uses a single preprocess and detection worker" << std::endl;
+                options_.preprocess_workers = 1;
+                options_.detection_workers = 1;
+            }
+            CircleTracker::Params params;
+            params.full_search_interval = options_.full_search_interval;
+            tracker_ = std::make_unique<CircleTracker>(params);
+        }
+    }
+
+    ImageProcessor::~ImageProcessor() {
+        // 输出阶段异常退出时，丢弃剩余任务以免上游阻塞在满队列上
+        discard_ = true;
+        RequestStop();
+        JoinWorkers();
+    }
 
     void ImageProcessor::ProcessImages() {
+        // 从日志恢复水位，只处理上次停止之后的帧
+        if (options_.use_journal && source_->Resumable()) {
+            const std::string journal_path = options_.journal_path.empty()
+                                             ? folder_path_ + "processed.journal" : options_.journal_path;
+            journal_ = std::make_unique<ProcessedJournal>(journal_path);
+            enqueued_watermark_ = journal_->HighWatermark();
+            // 日志最后一条记录的时间：水位以下却比它新的帧说明相机帧计数已重置（或日志是别处遗留的）
+            std::filesystem::file_time_type last_record;
+            if (enqueued_watermark_ >= 0 && journal_->LastRecordTime(last_record)) {
+                const int64_t reset = source_->FindCounterReset(enqueued_watermark_, last_record);
+                if (reset >= 0) {
+                    std::cerr << "Frame " << reset << " is newer than the journal but below its watermark "
+                              << enqueued_watermark_ << ", frame counter was reset; restarting from it" << std::endl;
+                    journal_->Restart(reset - 1);
+                    enqueued_watermark_ = reset - 1;
+                }
+            }
+            if (enqueued_watermark_ >= 0) {
+                std::cerr << "Resuming after frame " << enqueued_watermark_ << std::endl;
+            }
+        }
+
+        if (!options_.result_path.empty()) {
+            result_writer_ = std::make_unique<ResultWriter>(options_.result_path, options_.result_format);
+        }
+
+        // 收到 SIGINT/SIGTERM 时停止采集并排空流水线，保证结果完整写出
+        g_stop_signal = false;
+        auto previous_sigint = std::signal(SIGINT, HandleStopSignal);
+        auto previous_sigterm = std::signal(SIGTERM, HandleStopSignal);
+
+        stop_ = false;
+        ingest_done_ = false;
+        preprocess_running_ = options_.preprocess_workers;
+        detection_running_ = options_.detection_workers;
+
+        workers_.emplace_back(&ImageProcessor::IngestStage, this);
+        for (int i = 0; i < options_.preprocess_workers; ++i) {
+            workers_.emplace_back(&ImageProcessor::PreprocessStage, this);
+        }
+        for (int i = 0; i < options_.detection_workers; ++i) {
+            workers_.emplace_back(&ImageProcessor::DetectionStage, this);
+        }
+
+        // HighGUI 只能在一个线程中使用，输出阶段留在调用线程
+        OutputStage();
+        JoinWorkers();
+
+        std::signal(SIGINT, previous_sigint);
+        std::signal(SIGTERM, previous_sigterm);
+        result_writer_.reset();
+
+        // 无界面模式下标准输出可能用于结果，状态信息写到标准错误
+        (options_.headless ? std::cerr : std::cout)
+                << "\nTotal images processed: " << total_processed_ << std::endl;
+        if (tracker_) {
+            const CircleTracker::Stats stats = tracker_->GetStats();
+            (options_.headless ? std::cerr : std::cout)
+                    << "Circle tracking: " << stats.window_searches << " window, "
+                    << stats.full_searches << " full (" << stats.misses << " after miss)" << std::endl;
+        }
+        const FramePool::Stats pool_stats = FramePool::Shared().GetStats();
+        (options_.headless ? std::cerr : std::cout)
+                << "Frame pool: " << pool_stats.pooled_buffers << " buffers ("
+                << pool_stats.pooled_bytes / (1024 * 1024) << " MB), " << pool_stats.allocations
+                << " allocations, " << pool_stats.reuses << " reuses" << std::endl;
+    }
+
+    void ImageProcessor::PollStopSignal() {
+        if (g_stop_signal) RequestStop();
+    }
+
+    void ImageProcessor::RequestStop() {
+        stop_ = true;
+    }
+
+    QueueDepths ImageProcessor::GetQueueDepths() const {
+        QueueDepths depths;
+        depths.ingest = ingest_queue_.Size();
+        depths.detect = detect_queue_.Size();
+        depths.output = output_queue_.Size();
+        depths.reorder = reorder_depth_.load(std::memory_order_relaxed);
+        return depths;
+    }
+
+    void ImageProcessor::JoinWorkers() {
+        for (auto& worker : workers_) {
+            if (worker.joinable()) worker.join();
+        }
+        workers_.clear();
+    }
+
+    void ImageProcessor::PushBlocking(BoundedQueue<FrameJob>& queue, FrameJob& job) {
+        int attempts = 0;
+        while (!queue.TryPush(job)) {
+            if (discard_) return;
+            Backoff(attempts);
+        }
+    }
+
+    void ImageProcessor::IngestStage() {
+        TXMA_TRACE_THREAD("ingest");
+
+        // 来源构造时已建立监视，补扫期间写完的文件不会漏掉
+        {
+            TXMA_TRACE_SCOPE("FrameSource.ScanExisting");
+            EnqueueNewFrames(source_->ScanExisting(enqueued_watermark_));
+        }
+
+        while (!stop_) {
+            EnqueueNewFrames(source_->WaitForFrames(kWatchTimeoutMs, enqueued_watermark_));
+            PollStopSignal();
+        }
+        ingest_done_ = true;
+    }
+
+    void ImageProcessor::EnqueueNewFrames(std::vector<SourceFrame> frames) {
+        // 来源已按编号排序，水位判断为 O(1)，同一帧的重复事件也在此过滤
+        for (auto& frame : frames) {
+            if (stop_) return;
+            if (frame.number <= enqueued_watermark_)
+                continue;
+
+            FrameJob job;
+            job.sequence = next_sequence_++;
+            job.number = frame.number;
+            job.filename = std::move(frame.filename);
+            job.raw = std::move(frame.image);
+            job.lease = std::move(frame.lease);
+            enqueued_watermark_ = job.number;
+            PushBlocking(ingest_queue_, job);
+        }
+    }
+
+    void ImageProcessor::PreprocessStage() {
+        TXMA_TRACE_THREAD("preprocess");
+        FrameJob job;
+        int attempts = 0;
         while (true) {
-            std::vector<std::string> current_files;
-            for (const auto& entry : fs::directory_iterator(folder_path_)) {
-                if (entry.is_regular_file()) {
-                    std::string filename = entry.path().filename().string();
-                    if (filename.find("Image_") != std::string::npos &&
-                        filename.find(".png") != std::string::npos) {
-                        current_files.push_back(filename);
-                    }
+            if (!ingest_queue_.TryPop(job)) {
+                if (ingest_done_ && ingest_queue_.Empty()) break;
+                Backoff(attempts);
+                continue;
+            }
+            attempts = 0;
+            TXMA_TRACE_SCOPE("ImageProcessor.Preprocess");
+
+            // 边解码边降采样，不生成全分辨率图像；无界面模式不需要彩色叠加，直接读入灰度图
+            // 来源已提供内存中的原始帧时直接降采样，随后交还其内存；读取失败的帧照常下传以保持顺序
+            cv::Mat* full_gray = options_.subpixel_refine ? &job.full_gray : nullptr;
+            if (job.lease || !job.raw.empty()) {
+                job.image = ImageIngest::Downscale(job.raw, kDownscaleFactor, options_.headless, full_gray);
+                job.raw.release();
+                job.lease.reset();
+            } else {
+                job.image = ImageIngest::ReadDownscaled(folder_path_ + job.filename, kDownscaleFactor,
+                                                        options_.headless, full_gray, options_.raw_format);
+            }
+            if (!job.image.empty()) {
+                job.gray = PreprocessImage(job.image);
+            }
+            PushBlocking(detect_queue_, job);
+        }
+        preprocess_running_.fetch_sub(1);
+    }
+
+    void ImageProcessor::DetectionStage() {
+        TXMA_TRACE_THREAD("detection");
+        FrameJob job;
+        int attempts = 0;
+        while (true) {
+            if (!detect_queue_.TryPop(job)) {
+                if (preprocess_running_ == 0 && detect_queue_.Empty()) break;
+                Backoff(attempts);
+                continue;
+            }
+            attempts = 0;
+            TXMA_TRACE_SCOPE("ImageProcessor.Detection");
+
+            if (!job.gray.empty()) {
+                job.circles = DetectCircles(job.gray);
+                if (!job.full_gray.empty()) {
+                    SubpixelRefine::RefineCircles(job.full_gray, kDownscaleFactor, job.circles);
+                    job.full_gray.release();
                 }
+                job.distances = ComputeDistances(job.circles);
             }
+            PushBlocking(output_queue_, job);
+        }
+        detection_running_.fetch_sub(1);
+    }
+
+    void ImageProcessor::OutputStage() {
+        TXMA_TRACE_THREAD("output");
+        FrameJob job;
+        int attempts = 0;
+        auto last_activity = std::chrono::steady_clock::now();
+        while (true) {
+            if (output_queue_.TryPop(job)) {
+                attempts = 0;
+                const uint64_t sequence = job.sequence;
+                reorder_buffer_.emplace(sequence, std::move(job));
 
-            std::sort(current_files.begin(), current_files.end(),
-                      [this](const std::string& a, const std::string& b) {
-                          return ExtractNumber(a) < ExtractNumber(b);
-                      });
-
-            bool new_file_processed = false;
-            for (const auto& filename : current_files) {
-                if (processed_files_.find(filename) != processed_files_.end())
-                    continue;
-
-                std::string image_path = folder_path_ + filename;
-                ProcessSingleImage(image_path);
-                processed_files_.insert(filename);
-                total_processed_++;
-                new_file_processed = true;
+                // 多个检测线程的结果可能乱序到达，按顺序号依次输出
+                for (auto it = reorder_buffer_.find(next_output_); it != reorder_buffer_.end();
+                     it = reorder_buffer_.find(next_output_)) {
+                    OutputFrame(it->second);
+                    reorder_buffer_.erase(it);
+                    ++next_output_;
+                }
+                reorder_depth_.store(reorder_buffer_.size(), std::memory_order_relaxed);
+                last_activity = std::chrono::steady_clock::now();
+                continue;
             }
 
-            if (!new_file_processed) {
+            if (detection_running_ == 0 && output_queue_.Empty()) break;
+            PollStopSignal();
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now - last_activity >= std::chrono::milliseconds(kIdleTimeoutMs)) {
                 if (window_created_) {
                     cv::destroyWindow("Real-time detection");
                     window_created_ = false;
                 }
-                std::cout << "Monitoring... (processed " << total_processed_ << " images)"
-                          << " ESC to quit" << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+                const QueueDepths depths = GetQueueDepths();
+                (options_.headless ? std::cerr : std::cout)
+                        << "Monitoring... (processed " << total_processed_ << " images)"
+                        << " queues: ingest=" << depths.ingest << " detect=" << depths.detect
+                        << " output=" << depths.output << " reorder=" << depths.reorder
+                        << (options_.headless ? " Ctrl+C to quit" : " ESC to quit") << std::endl;
+                last_activity = now;
             }
+            Backoff(attempts);
         }
     }
 
-    int ImageProcessor::ExtractNumber(const std::string& filename) const {
-        size_t start = filename.find_last_of('_') + 1;
-        size_t end = filename.find_last_of('.');
-        return std::stoi(filename.substr(start, end - start));
-    }
+    void ImageProcessor::OutputFrame(const FrameJob& job) {
+        total_processed_++;
+        const bool loaded = !job.image.empty();
+        if (!loaded) {
+            std::cerr << "Unable to load image: " << folder_path_ + job.filename << std::endl;
+        }
 
-    void ImageProcessor::ProcessSingleImage(const std::string& image_path) {
-        cv::Mat src = cv::imread(image_path);
-        if (src.empty()) {
-            std::cerr << "Unable to load image: " << image_path << std::endl;
-            return;
+        if (result_writer_) {
+            TXMA_TRACE_SCOPE("ResultWriter.WriteFrame");
+            result_writer_->WriteFrame(job.number, job.filename, loaded, job.circles, job.distances);
         }
 
-        cv::Mat resized_image;
-        cv::resize(src, resized_image, cv::Size(src.cols / 5, src.rows / 5));
+        // 结果按编号顺序输出，此处推进日志水位；读取失败的帧同样记录，避免重启后反复重试
+        if (journal_) {
+            journal_->MarkProcessed(job.number);
+        }
+
+        // 无界面模式跳过所有绘制和 HighGUI 调用；停止后只排空流水线，不再等待按键
+        if (!loaded || options_.headless || stop_) return;
 
-        cv::Mat result = DetectAndDrawCircles(resized_image);
+        ShowFrame(job);
+    }
+
+    void ImageProcessor::ShowFrame(const FrameJob& job) {
+        cv::Mat result = DrawCircles(job.image, job.circles, job.distances);
 
         cv::imshow("Real-time detection", result);
         window_created_ = true;
 
-        int key = cv::waitKey(0);
+        // 等价于 waitKey(0)，但分段等待以便响应停止信号
+        int key = -1;
+        while (key < 0 && !stop_) {
+            key = cv::waitKey(kKeyPollMs);
+            PollStopSignal();
+        }
         if (key == 27) {
-            std::cout << "\nTotal images processed: " << total_processed_ << std::endl;
-            exit(0);
+            RequestStop();
         }
     }
 
-    cv::Mat ImageProcessor::DetectAndDrawCircles(const cv::Mat& image) const {
-        cv::Mat gray_image, blur_image;
-        cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
-        cv::medianBlur(gray_image, blur_image, 3);
+    cv::Mat ImageProcessor::PreprocessImage(const cv::Mat& image) const {
+        // 灰度图写入新缓冲区再原地滤波，不改动 image（彩色叠加仍要用到）
+        cv::Mat gray_image = FramePool::Shared().Acquire(image.size(), CV_8UC1);
+        if (image.channels() == 1) {
+            image.copyTo(gray_image);
+        } else {
+            TXMA_TRACE_SCOPE("ImageProcessor.cvtColor");
+            cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+        }
+        {
+            TXMA_TRACE_SCOPE("ImageProcessor.blur");
+            CirclePreprocess::ApplyBlur(ProductionPreprocess(kDetectionParams), gray_image);
+        }
+        return gray_image;
+    }
 
+    std::vector<cv::Vec3f> ImageProcessor::DetectCircles(const cv::Mat& gray) const {
         std::vector<cv::Vec3f> circles;
-        cv::HoughCircles(blur_image, circles, cv::HOUGH_GRADIENT, 2, 70, 150, 40, 15, 18);
+        // 跟踪模式下只有一个检测线程，帧按顺序号依次到达，以前一帧为参考
+        if (tracker_) {
+            tracker_->Detect(gray, kDetectionParams.max_radius, &ImageProcessor::HoughCircles, circles);
+        } else {
+            HoughCircles(gray, circles);
+        }
+        return circles;
+    }
+
+    void ImageProcessor::HoughCircles(const cv::Mat& gray, std::vector<cv::Vec3f>& circles) {
+        DetectCirclesWithParams(gray, kDetectionParams, circles);
+    }
+
+    std::vector<CircleDistance> ImageProcessor::ComputeDistances(const std::vector<cv::Vec3f>& circles) const {
+        return MeasurePitches(circles, options_.pitch);
+    }
 
-        cv::Mat result = image.clone();
+    cv::Mat ImageProcessor::DrawCircles(const cv::Mat& image, const std::vector<cv::Vec3f>& circles,
+                                        const std::vector<CircleDistance>& distances) const {
+        TXMA_TRACE_SCOPE("ImageProcessor.DrawCircles");
+        cv::Mat result = FramePool::Shared().Acquire(image.size(), image.type());
+        image.copyTo(result);
         std::vector<cv::Point> centers;
 
         for (const auto& circle : circles) {
@@ -108,21 +417,29 @@ namespace ImageProcessor {
             centers.push_back(center);
         }
 
-        for (size_t i = 0; i < centers.size(); ++i) {
-            for (size_t j = i + 1; j < centers.size(); ++j) {
-                double dx = centers[j].x - centers[i].x;
-                double dy = centers[j].y - centers[i].y;
-                double distance = std::sqrt(dx * dx + dy * dy);
+        for (const auto& distance : distances) {
+            const cv::Point& first = centers[distance.first];
+            const cv::Point& second = centers[distance.second];
 
-                cv::line(result, centers[i], centers[j], cv::Scalar(255, 0, 0), 2);
-                cv::Point mid = (centers[i] + centers[j]) / 2;
-                std::string dist_text = cv::format("%.2f px", distance);
-                cv::putText(result, dist_text, mid + cv::Point(0, -10),
-                            cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 255), 1);
-            }
+            cv::line(result, first, second, cv::Scalar(255, 0, 0), 2);
+            cv::Point mid = (first + second) / 2;
+            std::string dist_text = cv::format("%.2f px", distance.distance);
+            cv::putText(result, dist_text, mid + cv::Point(0, -10),
+                        cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 255, 255), 1);
         }
 
         return result;
     }
 
+    cv::Mat ImageProcessor::DetectAndDrawCircles(const cv::Mat& image) const {
+        const std::vector<cv::Vec3f> circles = DetectCircles(PreprocessImage(image));
+        return DrawCircles(image, circles, ComputeDistances(circles));
+    }
+
+    cv::Mat ImageProcessor::DetectAndDrawCircles(const cv::Mat& image, const cv::Mat& full_image) const {
+        std::vector<cv::Vec3f> circles = DetectCircles(PreprocessImage(image));
+        SubpixelRefine::RefineCircles(full_image, kDownscaleFactor, circles);
+        return DrawCircles(image, circles, ComputeDistances(circles));
+    }
+
 }  // namespace ImageProcessor
\ No newline at end of file
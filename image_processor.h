@@ -4,29 +4,148 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <string>
+#include <map>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <cstdint>
+#include "bounded_queue.h"
+#include "circle_tracker.h"
+#include "frame_source.h"
+#include "processed_journal.h"
+#include "result_writer.h"
 
 namespace ImageProcessor {
 
+// 流水线配置
+    struct PipelineOptions {
+        int preprocess_workers = 1;   // 解码与预处理线程数
+        int detection_workers = 2;    // 霍夫圆检测线程数
+        size_t queue_capacity = 8;    // 各级队列容量
+        bool headless = false;        // 无界面模式：不调用 HighGUI，不绘制结果
+        std::string result_path;      // 结果输出路径，"-" 为标准输出，空为不输出
+        ResultFormat result_format = ResultFormat::kJsonLines;  // 结果输出格式
+        bool use_journal = true;      // 是否持久化已处理帧，重启后从上次位置继续
+        std::string journal_path;     // 日志路径，空为 <文件夹>/processed.journal
+        bool track_circles = false;   // 帧间跟踪：只在上一帧圆附近检测，未命中时退回全图（预处理和检测线程固定为 1 个）
+        int full_search_interval = 30;  // 跟踪模式下强制全图检测的间隔帧数
+        PitchOptions pitch;           // 圆心距离测量方式，默认只测阵列相邻的孔距
+        bool subpixel_refine = false; // 在全分辨率灰度图上将圆心和半径精化到亚像素（每帧多保留一张全分辨率灰度图）
+        ImageIngest::RawFormat raw_format;  // Image_<编号>.raw（无文件头）的宽、高、通道数，未设置时忽略 .raw
+    };
+
+// 各级队列深度，用于监控流水线积压
+    struct QueueDepths {
+        size_t ingest = 0;      // 等待解码的文件
+        size_t detect = 0;      // 等待检测的图像
+        size_t output = 0;      // 等待输出的结果
+        size_t reorder = 0;     // 等待按编号排序输出的结果
+    };
+
 // 图像处理类
     class ImageProcessor {
     public:
         explicit ImageProcessor(const std::string& folder_path);
+        ImageProcessor(const std::string& folder_path, const PipelineOptions& options);
+
+        // 从任意帧来源（如共享内存环形缓冲区）取帧；来源不可断点续传时不使用已处理帧日志
+        ImageProcessor(std::unique_ptr<FrameSource> source, const PipelineOptions& options);
+        ~ImageProcessor();
+
+        // 启动流水线，输出阶段在调用线程上运行，直到按下 ESC 或收到 SIGINT/SIGTERM
         void ProcessImages();
 
-    private:
-        // 从文件名中提取数字
-        int ExtractNumber(const std::string& filename) const;
+        // 请求停止：不再接收新文件，流水线中的图像处理完后退出（线程安全）
+        void RequestStop();
 
-        // 处理单张图像
-        void ProcessSingleImage(const std::string& image_path);
+        // 当前各级队列深度
+        QueueDepths GetQueueDepths() const;
 
-        // 检测圆并绘制结果
+        // 单帧检测并绘制结果，不经过流水线；返回的图像取自 FramePool，释放后供下一帧复用
         cv::Mat DetectAndDrawCircles(const cv::Mat& image) const;
 
-        std::string folder_path_;       // 文件夹路径
-        std::set<std::string> processed_files_;  // 已处理的文件集合
+        // 同上，并在全分辨率图像（灰度或 BGR，image 的降采样倍数为 kDownscaleFactor）上做亚像素精化
+        cv::Mat DetectAndDrawCircles(const cv::Mat& image, const cv::Mat& full_image) const;
+
+    private:
+        // 流水线中传递的单帧任务
+        struct FrameJob {
+            uint64_t sequence = 0;             // 进入流水线的顺序号，输出按此排序
+            int64_t number = 0;                // 文件名中的帧编号
+            std::string filename;              // 文件名
+            cv::Mat raw;                       // 来源直接提供的全分辨率帧（零拷贝），预处理后释放
+            std::shared_ptr<void> lease;       // 保持 raw 所在内存有效，与 raw 一同释放
+            cv::Mat image;                     // 降采样后的图像（无界面模式下为灰度图）
+            cv::Mat gray;                      // 预处理后的灰度图像
+            cv::Mat full_gray;                 // 全分辨率灰度图像（仅亚像素精化时，检测后释放）
+            std::vector<cv::Vec3f> circles;    // 检测到的圆
+            std::vector<CircleDistance> distances;  // 圆心两两距离
+        };
+
+        // 按编号顺序将一批新帧送入流水线
+        void EnqueueNewFrames(std::vector<SourceFrame> frames);
+
+        // 各阶段线程函数
+        void IngestStage();
+        void PreprocessStage();
+        void DetectionStage();
+        void OutputStage();
+
+        // 输出单帧结果
+        void OutputFrame(const FrameJob& job);
+
+        // 灰度转换与滤波（生产预处理策略），中间结果使用 FramePool 中的缓冲区
+        cv::Mat PreprocessImage(const cv::Mat& image) const;
+
+        // 在预处理后的灰度图上检测圆，启用跟踪时优先在上一帧圆附近检测
+        std::vector<cv::Vec3f> DetectCircles(const cv::Mat& gray) const;
+
+        // 在灰度图（或其子区域）上按生产检测参数执行霍夫圆检测
+        static void HoughCircles(const cv::Mat& gray, std::vector<cv::Vec3f>& circles);
+
+        // 按配置测量圆心距离（按亚像素圆心）
+        std::vector<CircleDistance> ComputeDistances(const std::vector<cv::Vec3f>& circles) const;
+
+        // 在彩色图像上绘制检测结果
+        cv::Mat DrawCircles(const cv::Mat& image, const std::vector<cv::Vec3f>& circles,
+                            const std::vector<CircleDistance>& distances) const;
+
+        // 界面模式下显示结果并等待按键
+        void ShowFrame(const FrameJob& job);
+
+        // 检查是否收到 SIGINT/SIGTERM
+        void PollStopSignal();
+
+        // 入队，队列满时等待；析构时放弃
+        void PushBlocking(BoundedQueue<FrameJob>& queue, FrameJob& job);
+
+        // 等待流水线线程结束
+        void JoinWorkers();
+
+        std::unique_ptr<FrameSource> source_;  // 帧来源（仅采集线程访问）
+        std::string folder_path_;       // 文件夹路径（内存来源为空）
+        PipelineOptions options_;       // 流水线配置
+        std::unique_ptr<ProcessedJournal> journal_;  // 已处理帧日志（仅输出线程写入）
+        int64_t enqueued_watermark_ = -1;  // 已送入流水线的最大帧编号（仅采集线程访问）
         int total_processed_ = 0;      // 已处理文件总数
         bool window_created_ = false;  // 窗口是否已创建
+        std::unique_ptr<ResultWriter> result_writer_;  // 结果写出器（仅输出线程访问）
+        std::unique_ptr<CircleTracker> tracker_;  // 帧间跟踪（只有一个检测线程，按帧顺序更新）
+
+        BoundedQueue<FrameJob> ingest_queue_;   // 采集 -> 预处理
+        BoundedQueue<FrameJob> detect_queue_;   // 预处理 -> 检测
+        BoundedQueue<FrameJob> output_queue_;   // 检测 -> 输出
+        std::map<uint64_t, FrameJob> reorder_buffer_;  // 乱序到达的结果（仅输出线程访问）
+        std::atomic<size_t> reorder_depth_{0};  // 排序缓冲区大小，供监控读取
+        uint64_t next_sequence_ = 0;            // 下一个分配的顺序号（仅采集线程访问）
+        uint64_t next_output_ = 0;              // 下一个应输出的顺序号（仅输出线程访问）
+
+        std::atomic<bool> stop_{false};         // 停止请求
+        std::atomic<bool> discard_{false};      // 放弃剩余任务（析构时）
+        std::atomic<bool> ingest_done_{false};  // 采集阶段已退出
+        std::atomic<int> preprocess_running_{0};  // 仍在运行的预处理线程数
+        std::atomic<int> detection_running_{0};   // 仍在运行的检测线程数
+        std::vector<std::thread> workers_;      // 流水线线程
     };
 
 }  // namespace ImageProcessor
@@ -1,8 +1,101 @@
 #include "image_processor.h"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
 
-int main() {
-    const std::string folder_path = "E:/MVS_data/MV-CU120-10GC (K62277828)/";
-    ImageProcessor::ImageProcessor processor(folder_path);
+namespace {
+
+    // 解析完整的十进制整数参数，不接受多余字符和小于 min_value 的值
+    bool ParseInt(const char* text, int min_value, int& value) {
+        int parsed;
+        const char* last = text + std::strlen(text);
+        const auto [end, ec] = std::from_chars(text, last, parsed);
+        if (ec != std::errc() || end != last || parsed < min_value) return false;
+        value = parsed;
+        return true;
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string folder_path = "E:/MVS_data/MV-CU120-10GC (K62277828)/";
+    std::string shm_name;
+    ImageProcessor::PipelineOptions options;
+
+    // 用法: txma [--headless] [--output <path|->] [--format jsonl|csv] [--workers N] [--track]
+    //            [--full-search-interval N] [--subpixel] [--distances lattice|knn|all] [--neighbors K]
+    //            [--shm <name>] [--raw WxH[xC]] [folder]
+    // --full-search-interval 为跟踪模式下强制全图检测的间隔帧数（默认 30）
+    // --shm 从共享内存环形缓冲区（txma_replay 或相机进程写入）取原始帧，不再监视文件夹
+    // --raw 接受无文件头的 Image_<编号>.raw 帧（C 为通道数，默认 1）；PGM / PPM / BMP 无需参数
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--output" && i + 1 < argc) {
+            options.result_path = argv[++i];
+        } else if (arg == "--format" && i + 1 < argc) {
+            if (!ImageProcessor::ResultWriter::ParseFormat(argv[++i], options.result_format)) {
+                std::cerr << "Unknown result format: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--workers" && i + 1 < argc) {
+            if (!ParseInt(argv[++i], 1, options.detection_workers)) {
+                std::cerr << "Invalid worker count: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--distances" && i + 1 < argc) {
+            if (!ImageProcessor::ParseDistanceMode(argv[++i], options.pitch.mode)) {
+                std::cerr << "Unknown distance mode: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--neighbors" && i + 1 < argc) {
+            if (!ParseInt(argv[++i], 1, options.pitch.neighbors)) {
+                std::cerr << "Invalid neighbor count: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--shm" && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (arg == "--raw" && i + 1 < argc) {
+            ImageIngest::RawFormat& raw = options.raw_format;
+            raw.channels = 1;
+            if (std::sscanf(argv[++i], "%dx%dx%d", &raw.width, &raw.height, &raw.channels) < 2 ||
+                raw.width <= 0 || raw.height <= 0 || (raw.channels != 1 && raw.channels != 3)) {
+                std::cerr << "Invalid raw format: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--subpixel") {
+            options.subpixel_refine = true;
+        } else if (arg == "--track") {
+            options.track_circles = true;
+        } else if (arg == "--full-search-interval" && i + 1 < argc) {
+            if (!ParseInt(argv[++i], 1, options.full_search_interval)) {
+                std::cerr << "Invalid full search interval: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (!arg.empty() && arg[0] != '-') {
+            folder_path = arg;
+            if (folder_path.back() != '/' && folder_path.back() != '\\') folder_path += '/';
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // 无界面模式默认将结果写到标准输出
+    if (options.headless && options.result_path.empty()) {
+        options.result_path = "-";
+    }
+
+    if (!shm_name.empty()) {
+        ImageProcessor::ImageProcessor processor(
+                std::make_unique<ImageProcessor::SharedMemoryFrameSource>(shm_name), options);
+        processor.ProcessImages();
+        return 0;
+    }
+
+    ImageProcessor::ImageProcessor processor(folder_path, options);
     processor.ProcessImages();
     return 0;
 }
\ No newline at end of file
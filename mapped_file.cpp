@@ -0,0 +1,141 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ImageProcessor {
+
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    bool MappedFile::OpenReadOnly(const std::string& path) {
+        return Map(path, 0, false);
+    }
+
+    bool MappedFile::OpenReadWrite(const std::string& path, size_t min_size) {
+        return Map(path, min_size, true);
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Map(const std::string& path, size_t min_size, bool writable) {
+        Close();
+
+        HANDLE file = CreateFileA(path.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                  writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size)) {
+            CloseHandle(file);
+            return false;
+        }
+        size_t size = static_cast<size_t>(file_size.QuadPart);
+        if (writable && size < min_size) {
+            size = min_size;
+        }
+        if (size == 0) {
+            CloseHandle(file);
+            return false;
+        }
+
+        const ULONGLONG mapping_size = size;
+        HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                            static_cast<DWORD>(mapping_size >> 32),
+                                            static_cast<DWORD>(mapping_size & 0xFFFFFFFFu), nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+        if (!view) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        file_handle_ = file;
+        mapping_handle_ = mapping;
+        data_ = static_cast<unsigned char*>(view);
+        size_ = size;
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_handle_) CloseHandle(mapping_handle_);
+        if (file_handle_) CloseHandle(file_handle_);
+        data_ = nullptr;
+        size_ = 0;
+        mapping_handle_ = nullptr;
+        file_handle_ = nullptr;
+    }
+
+    void MappedFile::Flush() {
+        if (!data_) return;
+        FlushViewOfFile(data_, size_);
+        FlushFileBuffers(file_handle_);
+    }
+#else
+    bool MappedFile::Map(const std::string& path, size_t min_size, bool writable) {
+        Close();
+
+        int fd = writable ? open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)
+                          : open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        if (writable && size < min_size) {
+            if (ftruncate(fd, static_cast<off_t>(min_size)) != 0) {
+                close(fd);
+                return false;
+            }
+            size = min_size;
+        }
+        if (size == 0) {
+            close(fd);
+            return false;
+        }
+
+        void* addr = mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                          MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+
+        fd_ = fd;
+        data_ = static_cast<unsigned char*>(addr);
+        size_ = size;
+        return true;
+    }
+
+    void MappedFile::Close() {
+        if (data_) munmap(data_, size_);
+        if (fd_ >= 0) close(fd_);
+        data_ = nullptr;
+        size_ = 0;
+        fd_ = -1;
+    }
+
+    void MappedFile::Flush() {
+        if (data_) msync(data_, size_, MS_ASYNC);
+    }
+#endif
+
+}  // namespace ImageProcessor
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace ImageProcessor {
+
+// 内存映射文件，POSIX 下使用 mmap，Windows 下使用 CreateFileMapping
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // 只读映射整个文件，失败返回 false
+        bool OpenReadOnly(const std::string& path);
+
+        // 读写映射，文件不存在时创建，小于 min_size 时扩展到 min_size，失败返回 false
+        bool OpenReadWrite(const std::string& path, size_t min_size);
+
+        // 解除映射并关闭文件
+        void Close();
+
+        // 将修改写回磁盘
+        void Flush();
+
+        bool IsOpen() const { return data_ != nullptr; }
+        unsigned char* Data() const { return data_; }
+        size_t Size() const { return size_; }
+
+    private:
+        bool Map(const std::string& path, size_t min_size, bool writable);
+
+        unsigned char* data_ = nullptr;  // 映射起始地址
+        size_t size_ = 0;                // 映射长度
+#ifdef _WIN32
+        void* file_handle_ = nullptr;     // 文件句柄
+        void* mapping_handle_ = nullptr;  // 映射对象句柄
+#else
+        int fd_ = -1;                     // 文件描述符
+#endif
+    };
+
+}  // namespace ImageProcessor
+
+#endif  // MAPPED_FILE_H
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "mapped_image.h"
+#include <cctype>
+#include <cstdint>
+
+namespace ImageIngest {
+
+    namespace {
+
+        enum class Format {
+            kNone,
+            kRaw,
+            kPgm,
+            kPpm,
+            kBmp
+        };
+
+        // 像素区在文件中的位置和布局
+        struct Layout {
+            int width = 0;
+            int height = 0;
+            int type = CV_8UC1;
+            size_t offset = 0;          // 像素区起始偏移
+            size_t step = 0;            // 文件中的行字节数（BMP 按 4 字节对齐）
+            bool rgb = false;
+            bool bottom_up = false;
+
+            size_t FileBytes() const { return offset + step * height; }
+        };
+
+        Format FormatOf(const std::string& path) {
+            const size_t dot = path.find_last_of('.');
+            if (dot == std::string::npos) return Format::kNone;
+            std::string extension = path.substr(dot + 1);
+            for (char& c : extension) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            if (extension == "raw") return Format::kRaw;
+            if (extension == "pgm") return Format::kPgm;
+            if (extension == "ppm") return Format::kPpm;
+            if (extension == "bmp") return Format::kBmp;
+            return Format::kNone;
+        }
+
+        uint16_t ReadLe16(const unsigned char* p) {
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        uint32_t ReadLe32(const unsigned char* p) {
+            return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+
+        // PNM 头："P5" / "P6"，以空白和 # 注释分隔的宽、高、最大值，之后恰好一个空白字符，只接受 8 位
+        bool ParsePnm(const unsigned char* data, size_t size, bool color, Layout& layout) {
+            if (size < 2 || data[0] != 'P' || data[1] != (color ? '6' : '5')) return false;
+
+            size_t pos = 2;
+            int values[3];
+            for (int& value : values) {
+                while (pos < size) {
+                    if (std::isspace(data[pos])) {
+                        ++pos;
+                    } else if (data[pos] == '#') {
+                        while (pos < size && data[pos] != '\n') ++pos;
+                    } else {
+                        break;
+                    }
+                }
+                int digits = 0;
+                value = 0;
+                while (pos < size && std::isdigit(data[pos])) {
+                    if (++digits > 9) return false;
+                    value = value * 10 + (data[pos++] - '0');
+                }
+                if (digits == 0) return false;
+            }
+            if (pos >= size || !std::isspace(data[pos])) return false;
+            if (values[0] <= 0 || values[1] <= 0 || values[2] <= 0 || values[2] > 255) return false;
+
+            const int channels = color ? 3 : 1;
+            layout.width = values[0];
+            layout.height = values[1];
+            layout.type = color ? CV_8UC3 : CV_8UC1;
+            layout.offset = pos + 1;
+            layout.step = static_cast<size_t>(layout.width) * channels;
+            layout.rgb = color;
+            return true;
+        }
+
+        // BMP：BITMAPFILEHEADER + BITMAPINFOHEADER 及其扩展，只接受未压缩的 24 位和灰度调色板的 8 位
+        bool ParseBmp(const unsigned char* data, size_t size, Layout& layout) {
+            constexpr size_t kFileHeaderBytes = 14;
+            if (size < kFileHeaderBytes + 40 || data[0] != 'B' || data[1] != 'M') return false;
+
+            const uint32_t offset = ReadLe32(data + 10);
+            const uint32_t info_bytes = ReadLe32(data + 14);
+            const int32_t width = static_cast<int32_t>(ReadLe32(data + 18));
+            const int32_t height = static_cast<int32_t>(ReadLe32(data + 22));
+            const uint16_t planes = ReadLe16(data + 26);
+            const uint16_t bits = ReadLe16(data + 28);
+            const uint32_t compression = ReadLe32(data + 30);
+            if (info_bytes < 40 || width <= 0 || height == 0 || height == INT32_MIN || planes != 1 ||
+                compression != 0) {
+                return false;
+            }
+
+            if (bits == 8) {
+                // 调色板必须是灰度阶梯（第 i 项为 (i, i, i)），像素值才是亮度
+                uint32_t colors = ReadLe32(data + 46);
+                if (colors == 0) colors = 256;
+                const size_t palette = kFileHeaderBytes + info_bytes;
+                if (colors > 256 || palette + colors * 4 > offset || palette + colors * 4 > size) return false;
+                for (uint32_t i = 0; i < colors; ++i) {
+                    const unsigned char* entry = data + palette + i * 4;
+                    if (entry[0] != i || entry[1] != i || entry[2] != i) return false;
+                }
+                layout.type = CV_8UC1;
+            } else if (bits == 24) {
+                layout.type = CV_8UC3;
+            } else {
+                return false;
+            }
+
+            layout.width = width;
+            layout.height = height > 0 ? height : -height;
+            layout.offset = offset;
+            layout.step = (static_cast<size_t>(width) * (bits / 8) + 3) & ~static_cast<size_t>(3);
+            layout.bottom_up = height > 0;
+            return true;
+        }
+
+        bool ParseLayout(Format format, const unsigned char* data, size_t size, const RawFormat& raw,
+                         Layout& layout) {
+            switch (format) {
+                case Format::kRaw:
+                    if (raw.width <= 0 || raw.height <= 0 || (raw.channels != 1 && raw.channels != 3)) return false;
+                    layout.width = raw.width;
+                    layout.height = raw.height;
+                    layout.type = raw.channels == 3 ? CV_8UC3 : CV_8UC1;
+                    layout.offset = 0;
+                    layout.step = static_cast<size_t>(raw.width) * raw.channels;
+                    return true;
+                case Format::kPgm:
+                    return ParsePnm(data, size, false, layout);
+                case Format::kPpm:
+                    return ParsePnm(data, size, true, layout);
+                case Format::kBmp:
+                    return ParseBmp(data, size, layout);
+                default:
+                    return false;
+            }
+        }
+
+    }  // namespace
+
+    bool IsUncompressedImage(const std::string& path) {
+        return FormatOf(path) != Format::kNone;
+    }
+
+    size_t ExpectedFileSize(const std::string& path, const unsigned char* head, size_t head_size,
+                            const RawFormat& raw) {
+        Layout layout;
+        if (!ParseLayout(FormatOf(path), head, head_size, raw, layout)) return 0;
+        return layout.FileBytes();
+    }
+
+    bool MapImage(const std::string& path, const RawFormat& raw, MappedImage& image) {
+        const Format format = FormatOf(path);
+        if (format == Format::kNone) return false;
+
+        auto file = std::make_shared<ImageProcessor::MappedFile>();
+        if (!file->OpenReadOnly(path)) return false;
+
+        Layout layout;
+        if (!ParseLayout(format, file->Data(), file->Size(), raw, layout) || file->Size() < layout.FileBytes()) {
+            return false;
+        }
+
+        // 映射为只读，cv::Mat 需要非 const 指针，使用方只读取
+        image.pixels = cv::Mat(layout.height, layout.width, layout.type, file->Data() + layout.offset, layout.step);
+        image.rgb = layout.rgb;
+        image.bottom_up = layout.bottom_up;
+        image.file = std::move(file);
+        return true;
+    }
+
+}  // namespace ImageIngest
\ No newline at end of file
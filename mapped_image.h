@@ -0,0 +1,46 @@
+#ifndef MAPPED_IMAGE_H
+#define MAPPED_IMAGE_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "mapped_file.h"
+
+namespace ImageIngest {
+
+    // 无文件头 .raw 帧的格式，由相机配置决定；width 为 0 时不接受 .raw
+    struct RawFormat {
+        int width = 0;
+        int height = 0;
+        int channels = 1;               // 1: 灰度, 3: BGR
+
+        size_t FrameBytes() const { return static_cast<size_t>(width) * height * channels; }
+    };
+
+    // 映射后的未压缩图像：像素直接位于文件映射中，不拷贝、不解码
+    struct MappedImage {
+        cv::Mat pixels;                 // 映射区域上的只读视图（CV_8UC1 或 CV_8UC3），不可写入
+        bool rgb = false;               // 通道顺序为 RGB（PPM），否则为 BGR 或灰度
+        bool bottom_up = false;         // 行自下而上存放（BMP 默认），pixels 的第 0 行是图像最后一行
+        std::shared_ptr<ImageProcessor::MappedFile> file;  // 映射，最后一个引用释放时解除
+    };
+
+    // 判断文件头时读取的字节数，足以容纳带注释的 PNM 头和 8 位 BMP 的调色板
+    constexpr size_t kHeaderProbeBytes = 2048;
+
+    // 按扩展名判断是否为可映射的未压缩格式（.raw / .pgm / .ppm / .bmp，不区分大小写）
+    bool IsUncompressedImage(const std::string& path);
+
+    // 由文件头计算未压缩图像文件的完整字节数，用于判断相机是否已写完；head 为文件开头的 head_size 字节
+    // 格式不支持（16 位 PNM、压缩或调色板 BMP 等）或文件头不完整时返回 0
+    size_t ExpectedFileSize(const std::string& path, const unsigned char* head, size_t head_size,
+                            const RawFormat& raw = RawFormat());
+
+    // 只读映射 path 并把像素区包装成 cv::Mat 头；支持 8 位 PGM(P5) / PPM(P6)、8 位灰度与 24 位 BMP、
+    // 按 raw 解释的 .raw。格式不支持或文件不完整时返回 false，调用方可退回 cv::imread
+    bool MapImage(const std::string& path, const RawFormat& raw, MappedImage& image);
+
+}  // namespace ImageIngest
+
+#endif  // MAPPED_IMAGE_H
\ No newline at end of file
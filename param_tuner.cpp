@@ -0,0 +1,462 @@
+// DetectionParams 自动调参工具：在带标注的图像集上并行地网格/随机搜索霍夫圆检测参数
+// 预处理按滤波配置缓存（降采样灰度图只生成一次，每种滤波对每张图只做一次），每组参数只重跑霍夫检测；
+// 输出每组参数的精确率、召回率和单帧耗时（滤波 + 检测），并给出满足精度目标的最快配置
+// 用法: txma_tune (--labels <文件> | --synthetic N) [--random K] [--seed S] [--downscale F] [--repeat N]
+//                 [--min-recall R] [--min-precision P] [--tolerance T] [--top N] [--csv <路径>]
+// 标注文件每行一个圆: <图像路径> <x> <y> <r>（全分辨率坐标，相对路径相对于标注文件所在目录），
+// 只有路径的行表示不含圆的图像，# 开头的行为注释；--synthetic 生成 N 张合成图像代替标注集
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "band_circle_detector.h"
+#include "circle_text.h"
+#include "image_ingest.h"
+#include "synthetic_images.h"
+#include "work_stealing_pool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // 带标注的图像，真实圆为全分辨率坐标
+    struct LabeledImage {
+        std::string path;                  // 图像路径（合成图像为空）
+        cv::Mat image;                     // 合成图像
+        std::vector<cv::Vec3f> truth;      // 真实圆
+    };
+
+    // 一种滤波配置，缓存的预处理结果以它为键
+    struct BlurConfig {
+        int type;
+        int size;
+    };
+
+    // 一组待评估的参数及其结果
+    struct Trial {
+        CircleDetectionParams params;
+        size_t blur = 0;                   // BlurConfig 的下标
+        double blur_ms = 0.0;              // 平均每帧滤波耗时
+        double hough_ms = 0.0;             // 平均每帧检测耗时
+        size_t truth = 0;                  // 真实圆总数
+        size_t detected = 0;               // 检测到的圆总数
+        size_t matched = 0;                // 一一匹配上的圆数
+        double precision = 0.0;
+        double recall = 0.0;
+
+        double RuntimeMs() const { return blur_ms + hough_ms; }
+    };
+
+    // 搜索空间：每个维度的候选值，网格搜索取笛卡尔积，随机搜索在各维度上独立均匀采样
+    struct SearchSpace {
+        std::vector<BlurConfig> blurs;
+        std::vector<double> dps;
+        std::vector<double> min_dists;
+        std::vector<double> param1s;
+        std::vector<double> param2s;
+        std::vector<int> radius_margins;   // 在标注半径范围两侧各扩展的像素数（降采样后）
+        std::vector<int> detector_types;
+        int min_radius = 0;                // 标注半径范围（降采样后）
+        int max_radius = 0;
+    };
+
+    bool LoadLabels(const std::string& labels_path, std::vector<LabeledImage>& images) {
+        std::ifstream file(labels_path);
+        if (!file) return false;
+
+        const fs::path base = fs::path(labels_path).parent_path();
+        std::map<std::string, size_t> index;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            std::string path;
+            if (!(fields >> path) || path[0] == '#') continue;
+            if (fs::path(path).is_relative()) path = (base / path).string();
+
+            auto it = index.find(path);
+            if (it == index.end()) {
+                it = index.emplace(path, images.size()).first;
+                images.push_back(LabeledImage{path, cv::Mat(), {}});
+            }
+            float x, y, r;
+            if (fields >> x >> y >> r) images[it->second].truth.emplace_back(x, y, r);
+        }
+        return true;
+    }
+
+    void MakeSyntheticImages(int count, uint64_t seed, std::vector<LabeledImage>& images) {
+        // 与基准测试相同：全分辨率半径 80，对应 1/5 降采样后的 16，圆数量不同
+        const int counts[] = {4, 16, 64};
+        for (int i = 0; i < count; ++i) {
+            LabeledImage labeled;
+            labeled.image = Synthetic::MakeCircleImage(cv::Size(2000, 1500), counts[i % 3], 80, seed + i,
+                                                       &labeled.truth);
+            images.push_back(std::move(labeled));
+        }
+    }
+
+    // 由标注推导搜索空间：半径带围绕标注半径，圆心最小间距取标注中最近圆心距的比例
+    SearchSpace MakeSearchSpace(const std::vector<LabeledImage>& images, int downscale) {
+        SearchSpace space;
+        space.blurs = {{CirclePreprocess::kNoBlur, 1},
+                       {CirclePreprocess::kMedianBlur, 3},
+                       {CirclePreprocess::kMedianBlur, 5},
+                       {CirclePreprocess::kGaussianBlur, 3},
+                       {CirclePreprocess::kGaussianBlur, 5},
+                       {CirclePreprocess::kBoxBlur, 3}};
+        space.dps = {1.0, 1.5, 2.0};
+        space.param1s = {100.0, 150.0, 200.0};
+        space.param2s = {30.0, 40.0, 50.0};
+        space.radius_margins = {1, 3, 5};
+        space.detector_types = {1, 2};
+
+        float radius_min = std::numeric_limits<float>::max();
+        float radius_max = 0.0f;
+        float spacing = std::numeric_limits<float>::max();
+        for (const auto& image : images) {
+            for (size_t i = 0; i < image.truth.size(); ++i) {
+                radius_min = std::min(radius_min, image.truth[i][2]);
+                radius_max = std::max(radius_max, image.truth[i][2]);
+                for (size_t j = i + 1; j < image.truth.size(); ++j) {
+                    spacing = std::min(spacing, static_cast<float>(std::hypot(image.truth[i][0] - image.truth[j][0],
+                                                                             image.truth[i][1] - image.truth[j][1])));
+                }
+            }
+        }
+        space.min_radius = static_cast<int>(std::floor(radius_min / downscale));
+        space.max_radius = static_cast<int>(std::ceil(radius_max / downscale));
+
+        // 标注中没有两个圆同时出现时无法推导间距，退回默认参数
+        if (spacing == std::numeric_limits<float>::max()) {
+            space.min_dists = {CircleDetectionParams().min_dist};
+        } else {
+            space.min_dists = {0.5 * spacing / downscale, 0.8 * spacing / downscale};
+        }
+        return space;
+    }
+
+    // 按下标组合生成一组参数；窄半径带检测不适用时返回 false
+    bool MakeTrial(const SearchSpace& space, const size_t (&choice)[7], int downscale, Trial& trial) {
+        CircleDetectionParams& params = trial.params;
+        const BlurConfig& blur = space.blurs[choice[0]];
+        trial.blur = choice[0];
+        params.blur_type = blur.type;
+        params.blur_size = blur.size;
+        params.downscale = downscale;
+        params.keep_color = false;
+        params.dp = space.dps[choice[1]];
+        params.min_dist = space.min_dists[choice[2]];
+        params.param1 = space.param1s[choice[3]];
+        params.param2 = space.param2s[choice[4]];
+        params.min_radius = std::max(1, space.min_radius - space.radius_margins[choice[5]]);
+        params.max_radius = space.max_radius + space.radius_margins[choice[5]];
+        params.detector_type = space.detector_types[choice[6]];
+        return params.detector_type != 2 ||
+               params.max_radius - params.min_radius < BandCircleDetector::kMaxRadiusBand;
+    }
+
+    std::vector<Trial> GridTrials(const SearchSpace& space, int downscale) {
+        const size_t sizes[7] = {space.blurs.size(), space.dps.size(), space.min_dists.size(), space.param1s.size(),
+                                 space.param2s.size(), space.radius_margins.size(), space.detector_types.size()};
+        std::vector<Trial> trials;
+        size_t choice[7] = {};
+        while (true) {
+            Trial trial;
+            if (MakeTrial(space, choice, downscale, trial)) trials.push_back(trial);
+
+            // 逐位进位遍历笛卡尔积，滤波维度在最高位，同一滤波的参数相邻
+            int axis = 6;
+            while (axis >= 0 && ++choice[axis] == sizes[axis]) choice[axis--] = 0;
+            if (axis < 0) break;
+        }
+        return trials;
+    }
+
+    std::vector<Trial> RandomTrials(const SearchSpace& space, int downscale, int count, uint64_t seed) {
+        const size_t sizes[7] = {space.blurs.size(), space.dps.size(), space.min_dists.size(), space.param1s.size(),
+                                 space.param2s.size(), space.radius_margins.size(), space.detector_types.size()};
+        size_t total = 1;
+        for (size_t size : sizes) total *= size;
+
+        std::mt19937_64 rng(seed);
+        std::set<std::vector<size_t>> seen;
+        std::vector<Trial> trials;
+        // 不放回采样，组合取尽或失败次数过多时停止
+        for (size_t attempts = 0; trials.size() < static_cast<size_t>(count) && seen.size() < total &&
+                                  attempts < total * 4; ++attempts) {
+            size_t choice[7];
+            for (int axis = 0; axis < 7; ++axis) choice[axis] = rng() % sizes[axis];
+            if (!seen.insert(std::vector<size_t>(choice, choice + 7)).second) continue;
+
+            Trial trial;
+            if (MakeTrial(space, choice, downscale, trial)) trials.push_back(trial);
+        }
+        return trials;
+    }
+
+    // 检测结果与真实圆（已缩放到降采样坐标）一一匹配：每个检测取 tolerance 内最近的未匹配真实圆
+    size_t CountMatches(const std::vector<cv::Vec3f>& truth, const std::vector<cv::Vec3f>& detected, double tolerance) {
+        std::vector<char> used(truth.size(), 0);
+        size_t matched = 0;
+        for (const auto& circle : detected) {
+            size_t best = truth.size();
+            double best_distance = tolerance;
+            for (size_t i = 0; i < truth.size(); ++i) {
+                const double distance = std::hypot(truth[i][0] - circle[0], truth[i][1] - circle[1]);
+                if (!used[i] && distance < best_distance) {
+                    best = i;
+                    best_distance = distance;
+                }
+            }
+            if (best < truth.size()) {
+                used[best] = 1;
+                ++matched;
+            }
+        }
+        return matched;
+    }
+
+    double ElapsedMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const char* BlurName(int type) {
+        switch (type) {
+            case CirclePreprocess::kMedianBlur: return "median";
+            case CirclePreprocess::kGaussianBlur: return "gauss";
+            case CirclePreprocess::kBoxBlur: return "box";
+            default: return "none";
+        }
+    }
+
+    void PrintTrial(const Trial& trial) {
+        const CircleDetectionParams& p = trial.params;
+        std::printf("%9.3f %9.3f %7.3f %7.3f  %-6s %d  %4.1f %7.1f %6.0f %6.0f %4d-%-4d %d\n",
+                    trial.RuntimeMs(), trial.hough_ms, trial.precision, trial.recall, BlurName(p.blur_type),
+                    p.blur_size, p.dp, p.min_dist, p.param1, p.param2, p.min_radius, p.max_radius, p.detector_type);
+    }
+
+    // 解析完整的数值参数，不接受多余字符和小于 min_value 的值
+    template <class T>
+    bool ParseNumber(const char* text, T min_value, T& value) {
+        T parsed;
+        const char* last = text + std::strlen(text);
+        const auto [end, ec] = std::from_chars(text, last, parsed);
+        if (ec != std::errc() || end != last || !(parsed >= min_value)) return false;
+        value = parsed;
+        return true;
+    }
+
+    void PrintUsage() {
+        std::cerr << "Usage: txma_tune (--labels <file> | --synthetic N) [--random K] [--seed S] [--downscale F]\n"
+                     "                 [--repeat N] [--min-recall R] [--min-precision P] [--tolerance T] [--top N]\n"
+                     "                 [--csv <path>]   (labels need at least one circle)" << std::endl;
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string labels_path;
+    std::string csv_path;
+    int synthetic = 0;
+    int random_count = 0;
+    uint64_t seed = 1;
+    int downscale = CircleDetectionParams().downscale;
+    int repeat = 2;
+    double min_recall = 0.95;
+    double min_precision = 0.95;
+    double tolerance = 3.0;
+    int top = 20;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        bool valid = true;
+        if (arg == "--labels" && has_value) {
+            labels_path = argv[++i];
+        } else if (arg == "--synthetic" && has_value) {
+            valid = ParseNumber(argv[++i], 0, synthetic);
+        } else if (arg == "--random" && has_value) {
+            valid = ParseNumber(argv[++i], 0, random_count);
+        } else if (arg == "--seed" && has_value) {
+            valid = ParseNumber<uint64_t>(argv[++i], 0, seed);
+        } else if (arg == "--downscale" && has_value) {
+            valid = ParseNumber(argv[++i], 1, downscale);
+        } else if (arg == "--repeat" && has_value) {
+            valid = ParseNumber(argv[++i], 1, repeat);
+        } else if (arg == "--min-recall" && has_value) {
+            valid = ParseNumber(argv[++i], 0.0, min_recall);
+        } else if (arg == "--min-precision" && has_value) {
+            valid = ParseNumber(argv[++i], 0.0, min_precision);
+        } else if (arg == "--tolerance" && has_value) {
+            valid = ParseNumber(argv[++i], 0.0, tolerance);
+        } else if (arg == "--top" && has_value) {
+            valid = ParseNumber(argv[++i], 0, top);
+        } else if (arg == "--csv" && has_value) {
+            csv_path = argv[++i];
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            PrintUsage();
+            return 1;
+        }
+        if (!valid) {
+            std::cerr << "Invalid value for " << arg << ": " << argv[i] << std::endl;
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    std::vector<LabeledImage> images;
+    if (!labels_path.empty()) {
+        if (!LoadLabels(labels_path, images)) {
+            std::cerr << "Unable to read labels: " << labels_path << std::endl;
+            return 1;
+        }
+    } else if (synthetic > 0) {
+        MakeSyntheticImages(synthetic, seed, images);
+    }
+    const bool any_truth = std::any_of(images.begin(), images.end(),
+                                       [](const LabeledImage& image) { return !image.truth.empty(); });
+    if (images.empty() || !any_truth) {
+        PrintUsage();
+        return 1;
+    }
+
+    const SearchSpace space = MakeSearchSpace(images, downscale);
+    std::vector<Trial> trials = random_count > 0 ? RandomTrials(space, downscale, random_count, seed)
+                                                 : GridTrials(space, downscale);
+
+    // 单线程运行 OpenCV 内部的并行，每组参数的耗时只反映它自己，参数组之间由线程池并行
+    cv::setNumThreads(1);
+    ImageProcessor::WorkStealingPool& pool = ImageProcessor::WorkStealingPool::Shared();
+
+    // 降采样灰度图：所有滤波配置共用，与 CircleDetector 在 keep_color 关闭时的读取路径一致
+    std::vector<cv::Mat> downscaled(images.size());
+    std::vector<std::vector<cv::Vec3f>> truth(images.size());
+    pool.ParallelFor(images.size(), [&](size_t index, int) {
+        const LabeledImage& image = images[index];
+        cv::Mat gray = image.path.empty() ? ImageIngest::Downscale(image.image, downscale, true)
+                                          : ImageIngest::ReadDownscaled(image.path, downscale, true);
+        downscaled[index] = gray.clone();
+        for (const auto& circle : image.truth) {
+            truth[index].emplace_back(circle[0] / downscale, circle[1] / downscale, circle[2] / downscale);
+        }
+    });
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (downscaled[i].empty()) {
+            std::cerr << "Unable to load image: " << images[i].path << std::endl;
+            return 1;
+        }
+    }
+
+    // 滤波缓存：每种滤波对每张图做一次，记录平均每帧耗时
+    const size_t blur_count = space.blurs.size();
+    std::vector<std::vector<cv::Mat>> blurred(blur_count, std::vector<cv::Mat>(images.size()));
+    std::vector<double> blur_ms(blur_count * images.size(), 0.0);
+    pool.ParallelFor(blur_count * images.size(), [&](size_t index, int) {
+        const size_t blur = index / images.size();
+        const size_t image = index % images.size();
+        CircleDetectionParams params;
+        params.blur_type = space.blurs[blur].type;
+        params.blur_size = space.blurs[blur].size;
+        const CirclePreprocess::RuntimePreprocess policy(params);
+
+        cv::Mat& output = blurred[blur][image];
+        double best = std::numeric_limits<double>::max();
+        for (int r = 0; r < repeat; ++r) {
+            output = downscaled[image].clone();
+            const auto start = std::chrono::steady_clock::now();
+            CirclePreprocess::ApplyBlur(policy, output);
+            best = std::min(best, ElapsedMs(start));
+        }
+        blur_ms[index] = best;
+    });
+
+    std::printf("%zu images, %zu configurations (%s search), %d worker slots, radius %d-%d after 1/%d downscale\n",
+                images.size(), trials.size(), random_count > 0 ? "random" : "grid", pool.Concurrency(),
+                space.min_radius, space.max_radius, downscale);
+
+    // 参数组分发到线程池，每组在所有图像上只重跑检测；耗时取 repeat 次中最短的一次
+    const auto search_start = std::chrono::steady_clock::now();
+    pool.ParallelFor(trials.size(), [&](size_t index, int) {
+        Trial& trial = trials[index];
+        std::vector<cv::Vec3f> circles;
+        for (size_t image = 0; image < images.size(); ++image) {
+            const cv::Mat& gray = blurred[trial.blur][image];
+            double best = std::numeric_limits<double>::max();
+            for (int r = 0; r < repeat; ++r) {
+                const auto start = std::chrono::steady_clock::now();
+                DetectCirclesWithParams(gray, trial.params, circles);
+                best = std::min(best, ElapsedMs(start));
+            }
+            trial.hough_ms += best;
+            trial.blur_ms += blur_ms[trial.blur * images.size() + image];
+            trial.truth += truth[image].size();
+            trial.detected += circles.size();
+            trial.matched += CountMatches(truth[image], circles, tolerance);
+        }
+        trial.hough_ms /= images.size();
+        trial.blur_ms /= images.size();
+        trial.precision = trial.detected ? static_cast<double>(trial.matched) / trial.detected : 1.0;
+        trial.recall = trial.truth ? static_cast<double>(trial.matched) / trial.truth : 1.0;
+    });
+    std::printf("search took %.1f s\n\n", ElapsedMs(search_start) / 1e3);
+
+    // 满足精度目标的按耗时升序，其余的排在后面按召回率、精确率降序
+    auto meets = [&](const Trial& trial) {
+        return trial.recall >= min_recall && trial.precision >= min_precision;
+    };
+    std::sort(trials.begin(), trials.end(), [&](const Trial& a, const Trial& b) {
+        if (meets(a) != meets(b)) return meets(a);
+        if (meets(a)) return a.RuntimeMs() < b.RuntimeMs();
+        if (a.recall != b.recall) return a.recall > b.recall;
+        return a.precision > b.precision;
+    });
+
+    std::printf("%9s %9s %7s %7s  %-8s %4s %7s %6s %6s %9s %s\n", "ms/frame", "hough ms", "prec", "recall", "blur",
+                "dp", "min_dst", "p1", "p2", "radius", "type");
+    for (int i = 0; i < top && i < static_cast<int>(trials.size()); ++i) PrintTrial(trials[i]);
+
+    if (!csv_path.empty()) {
+        std::ofstream csv(csv_path);
+        csv << "ms_per_frame,blur_ms,hough_ms,precision,recall,truth,detected,matched,blur_type,blur_size,dp,"
+               "min_dist,param1,param2,min_radius,max_radius,detector_type\n";
+        for (const auto& trial : trials) {
+            const CircleDetectionParams& p = trial.params;
+            csv << trial.RuntimeMs() << ',' << trial.blur_ms << ',' << trial.hough_ms << ',' << trial.precision << ','
+                << trial.recall << ',' << trial.truth << ',' << trial.detected << ',' << trial.matched << ','
+                << p.blur_type << ',' << p.blur_size << ',' << p.dp << ',' << p.min_dist << ',' << p.param1 << ','
+                << p.param2 << ',' << p.min_radius << ',' << p.max_radius << ',' << p.detector_type << '\n';
+        }
+    }
+
+    if (trials.empty() || !meets(trials.front())) {
+        std::printf("\nNo configuration reaches recall %.3f and precision %.3f; best by recall is listed first\n",
+                    min_recall, min_precision);
+        return 2;
+    }
+    const CircleDetectionParams& best = trials.front().params;
+    std::printf("\nFastest configuration with recall >= %.3f and precision >= %.3f:\n", min_recall, min_precision);
+    std::printf("    params.blur_type = %d;\n    params.blur_size = %d;\n    params.dp = %.1f;\n"
+                "    params.min_dist = %.1f;\n    params.param1 = %.0f;\n    params.param2 = %.0f;\n"
+                "    params.min_radius = %d;\n    params.max_radius = %d;\n    params.detector_type = %d;\n"
+                "    params.downscale = %d;\n",
+                best.blur_type, best.blur_size, best.dp, best.min_dist, best.param1, best.param2, best.min_radius,
+                best.max_radius, best.detector_type, best.downscale);
+    return 0;
+}
\ No newline at end of file
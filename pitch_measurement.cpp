@@ -0,0 +1,214 @@
+#include "pitch_measurement.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define TXMA_PITCH_SSE2 1
+#endif
+
+namespace ImageProcessor {
+
+    namespace {
+
+        struct Neighbor {
+            float distance2;   // 距离平方
+            int index;         // 圆的下标
+        };
+
+        // 圆心的均匀网格索引：单元边长约为平均间距，每个单元平均一个圆
+        // 单元内的圆按计数排序连续存放（CSR），查询时按单元顺序访问
+        class CenterGrid {
+        public:
+            explicit CenterGrid(const std::vector<cv::Vec3f>& circles) : circles_(circles) {
+                float min_x = circles[0][0], max_x = min_x, min_y = circles[0][1], max_y = min_y;
+                for (const auto& c : circles) {
+                    min_x = std::min(min_x, c[0]);
+                    max_x = std::max(max_x, c[0]);
+                    min_y = std::min(min_y, c[1]);
+                    max_y = std::max(max_y, c[1]);
+                }
+                const float area = std::max(max_x - min_x, 1.f) * std::max(max_y - min_y, 1.f);
+                cell_ = std::max(1.f, std::sqrt(area / circles.size()));
+                origin_x_ = min_x;
+                origin_y_ = min_y;
+                cols_ = static_cast<int>((max_x - min_x) / cell_) + 1;
+                rows_ = static_cast<int>((max_y - min_y) / cell_) + 1;
+
+                std::vector<int> cell_of(circles.size());
+                cell_start_.assign(static_cast<size_t>(cols_) * rows_ + 1, 0);
+                for (size_t i = 0; i < circles.size(); ++i) {
+                    cell_of[i] = CellIndex(CellX(circles[i][0]), CellY(circles[i][1]));
+                    ++cell_start_[cell_of[i] + 1];
+                }
+                for (size_t c = 1; c < cell_start_.size(); ++c) cell_start_[c] += cell_start_[c - 1];
+                members_.resize(circles.size());
+                std::vector<int> fill(cell_start_.begin(), cell_start_.end() - 1);
+                for (size_t i = 0; i < circles.size(); ++i) members_[fill[cell_of[i]]++] = static_cast<int>(i);
+            }
+
+            // 圆 i 的 k 个最近邻（不含自身），按距离升序
+            void Nearest(int i, int k, std::vector<Neighbor>& result) const {
+                result.clear();
+                const float x = circles_[i][0], y = circles_[i][1];
+                const int cx = CellX(x), cy = CellY(y);
+                const int max_ring = std::max(cols_, rows_);
+                auto worse = [](const Neighbor& a, const Neighbor& b) { return a.distance2 < b.distance2; };
+
+                // 按切比雪夫环逐圈扩展；第 r 圈之外的点距离至少为 r 个单元边长
+                for (int ring = 0; ring <= max_ring; ++ring) {
+                    for (int gy = cy - ring; gy <= cy + ring; ++gy) {
+                        if (gy < 0 || gy >= rows_) continue;
+                        const bool edge_row = gy == cy - ring || gy == cy + ring;
+                        for (int gx = cx - ring; gx <= cx + ring; gx += (edge_row || ring == 0) ? 1 : 2 * ring) {
+                            if (gx < 0 || gx >= cols_) continue;
+                            const int cell = CellIndex(gx, gy);
+                            for (int m = cell_start_[cell]; m < cell_start_[cell + 1]; ++m) {
+                                const int j = members_[m];
+                                if (j == i) continue;
+                                const float dx = circles_[j][0] - x, dy = circles_[j][1] - y;
+                                const Neighbor candidate{dx * dx + dy * dy, j};
+                                if (static_cast<int>(result.size()) < k) {
+                                    result.push_back(candidate);
+                                    std::push_heap(result.begin(), result.end(), worse);
+                                } else if (candidate.distance2 < result.front().distance2) {
+                                    std::pop_heap(result.begin(), result.end(), worse);
+                                    result.back() = candidate;
+                                    std::push_heap(result.begin(), result.end(), worse);
+                                }
+                            }
+                        }
+                    }
+                    const float reach = ring * cell_;
+                    if (static_cast<int>(result.size()) == k && result.front().distance2 <= reach * reach) break;
+                }
+                std::sort_heap(result.begin(), result.end(), worse);
+            }
+
+        private:
+            int CellX(float x) const { return std::clamp(static_cast<int>((x - origin_x_) / cell_), 0, cols_ - 1); }
+            int CellY(float y) const { return std::clamp(static_cast<int>((y - origin_y_) / cell_), 0, rows_ - 1); }
+            int CellIndex(int gx, int gy) const { return gy * cols_ + gx; }
+
+            const std::vector<cv::Vec3f>& circles_;
+            float cell_ = 1, origin_x_ = 0, origin_y_ = 0;
+            int cols_ = 1, rows_ = 1;
+            std::vector<int> cell_start_;   // 单元 c 的圆为 members_[cell_start_[c], cell_start_[c + 1])
+            std::vector<int> members_;
+        };
+
+        // 排序去重，i/j 顺序统一为 first < second
+        void Normalize(std::vector<CircleDistance>& pairs) {
+            for (auto& p : pairs) {
+                if (p.first > p.second) std::swap(p.first, p.second);
+            }
+            std::sort(pairs.begin(), pairs.end(), [](const CircleDistance& a, const CircleDistance& b) {
+                return a.first != b.first ? a.first < b.first : a.second < b.second;
+            });
+            pairs.erase(std::unique(pairs.begin(), pairs.end(), [](const CircleDistance& a, const CircleDistance& b) {
+                return a.first == b.first && a.second == b.second;
+            }), pairs.end());
+        }
+
+        double Distance(const cv::Vec3f& a, const cv::Vec3f& b) {
+            const double dx = static_cast<double>(b[0]) - a[0];
+            const double dy = static_cast<double>(b[1]) - a[1];
+            return std::sqrt(dx * dx + dy * dy);
+        }
+
+        // 阵列相邻判定需要的近邻数：方阵 4 个、六角阵 6 个，多取几个容纳测量误差
+        constexpr int kLatticeCandidates = 8;
+
+    }  // namespace
+
+    std::vector<CircleDistance> MeasurePitches(const std::vector<cv::Vec3f>& circles, const PitchOptions& options) {
+        TXMA_TRACE_SCOPE("Pitch.MeasurePitches");
+        std::vector<CircleDistance> pairs;
+        const int n = static_cast<int>(circles.size());
+        if (n < 2) return pairs;
+
+        if (options.mode == DistanceMode::kAllPairs) {
+            std::vector<float> matrix;
+            DistanceMatrix(circles, matrix);
+            pairs.reserve(static_cast<size_t>(n) * (n - 1) / 2);
+            for (int i = 0; i < n; ++i) {
+                for (int j = i + 1; j < n; ++j) {
+                    pairs.push_back({i, j, matrix[static_cast<size_t>(i) * n + j]});
+                }
+            }
+            return pairs;
+        }
+
+        const CenterGrid grid(circles);
+        std::vector<Neighbor> neighbors;
+        if (options.mode == DistanceMode::kNearest) {
+            const int k = std::clamp(options.neighbors, 1, n - 1);
+            pairs.reserve(static_cast<size_t>(n) * k);
+            for (int i = 0; i < n; ++i) {
+                grid.Nearest(i, k, neighbors);
+                for (const auto& nb : neighbors) pairs.push_back({i, nb.index, Distance(circles[i], circles[nb.index])});
+            }
+        } else {
+            // 以每个圆自己的最近邻距离为基准，容差内的近邻都算阵列相邻，孔距不均匀时也能成立
+            const int k = std::min(kLatticeCandidates, n - 1);
+            const float scale2 = static_cast<float>((1 + options.lattice_tolerance) * (1 + options.lattice_tolerance));
+            pairs.reserve(static_cast<size_t>(n) * 4);
+            for (int i = 0; i < n; ++i) {
+                grid.Nearest(i, k, neighbors);
+                const float limit2 = neighbors.front().distance2 * scale2;
+                for (const auto& nb : neighbors) {
+                    if (nb.distance2 > limit2) break;
+                    pairs.push_back({i, nb.index, Distance(circles[i], circles[nb.index])});
+                }
+            }
+        }
+        Normalize(pairs);
+        return pairs;
+    }
+
+    void DistanceMatrix(const std::vector<cv::Vec3f>& circles, std::vector<float>& matrix) {
+        TXMA_TRACE_SCOPE("Pitch.DistanceMatrix");
+        const int n = static_cast<int>(circles.size());
+        matrix.resize(static_cast<size_t>(n) * n);
+
+        // 圆心转为结构数组，便于按 4 个一组加载
+        std::vector<float> xs(n), ys(n);
+        for (int i = 0; i < n; ++i) {
+            xs[i] = circles[i][0];
+            ys[i] = circles[i][1];
+        }
+
+        for (int i = 0; i < n; ++i) {
+            float* row = matrix.data() + static_cast<size_t>(i) * n;
+            int j = 0;
+#if defined(TXMA_PITCH_SSE2)
+            const __m128 xi = _mm_set1_ps(xs[i]);
+            const __m128 yi = _mm_set1_ps(ys[i]);
+            for (; j + 4 <= n; j += 4) {
+                const __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs.data() + j), xi);
+                const __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys.data() + j), yi);
+                _mm_storeu_ps(row + j, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))));
+            }
+#endif
+            for (; j < n; ++j) {
+                const float dx = xs[j] - xs[i], dy = ys[j] - ys[i];
+                row[j] = std::sqrt(dx * dx + dy * dy);
+            }
+        }
+    }
+
+    bool ParseDistanceMode(const std::string& name, DistanceMode& mode) {
+        if (name == "lattice") {
+            mode = DistanceMode::kLattice;
+        } else if (name == "knn") {
+            mode = DistanceMode::kNearest;
+        } else if (name == "all") {
+            mode = DistanceMode::kAllPairs;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+}  // namespace ImageProcessor
\ No newline at end of file
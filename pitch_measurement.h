@@ -0,0 +1,43 @@
+#ifndef PITCH_MEASUREMENT_H
+#define PITCH_MEASUREMENT_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+namespace ImageProcessor {
+
+// 两个圆心之间的距离
+    struct CircleDistance {
+        int first = 0;         // 第一个圆的下标
+        int second = 0;        // 第二个圆的下标
+        double distance = 0;   // 圆心距离（像素）
+    };
+
+// 圆心距离的测量方式
+    enum class DistanceMode {
+        kLattice,    // 阵列相邻：距离不超过该圆最近邻距离 (1 + 容差) 倍的圆对，即孔板的行/列间距
+        kNearest,    // 每个圆的 k 个最近邻
+        kAllPairs    // 全部 n(n-1)/2 对（圆数较多时输出和绘制都不可读）
+    };
+
+// 距离测量配置
+    struct PitchOptions {
+        DistanceMode mode = DistanceMode::kLattice;  // 测量方式
+        int neighbors = 4;                 // kNearest 时每个圆的近邻数
+        double lattice_tolerance = 0.25;   // kLattice 时相对最近邻距离的容差，0.25 可排除方阵的对角线
+    };
+
+    // 按配置计算圆心距离对：first < second，按 (first, second) 排序且不重复
+    // kLattice/kNearest 基于均匀网格索引，复杂度近似 O(n)
+    std::vector<CircleDistance> MeasurePitches(const std::vector<cv::Vec3f>& circles, const PitchOptions& options);
+
+    // 完整距离矩阵，按行优先写入 n * n 的 float 缓冲区（matrix[i * n + j]），尺寸不变时复用缓冲区
+    void DistanceMatrix(const std::vector<cv::Vec3f>& circles, std::vector<float>& matrix);
+
+    // 解析测量方式名称（"lattice" / "knn" / "all"），无法识别时返回 false
+    bool ParseDistanceMode(const std::string& name, DistanceMode& mode);
+
+}  // namespace ImageProcessor
+
+#endif  // PITCH_MEASUREMENT_H
\ No newline at end of file
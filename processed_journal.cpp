@@ -0,0 +1,86 @@
+#include "processed_journal.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace ImageProcessor {
+
+    namespace {
+
+        constexpr uint32_t kJournalMagic = 0x314A5854;  // "TXJ1"
+        constexpr uint32_t kJournalVersion = 2;
+
+        // 每追加多少条记录主动刷盘一次
+        constexpr uint64_t kFlushInterval = 64;
+
+        int64_t NowNanoseconds() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::filesystem::file_time_type::clock::now().time_since_epoch()).count();
+        }
+
+    }  // namespace
+
+    ProcessedJournal::ProcessedJournal(const std::string& path, uint64_t capacity) {
+        capacity = std::max<uint64_t>(capacity, 1);
+        const size_t file_size = sizeof(Header) + capacity * sizeof(int64_t);
+        if (!file_.OpenReadWrite(path, file_size)) {
+            throw std::runtime_error("Unable to open journal: " + path);
+        }
+
+        Header* head = header();
+        if (head->magic != kJournalMagic || head->version != kJournalVersion || head->capacity == 0 ||
+            file_.Size() < sizeof(Header) + head->capacity * sizeof(int64_t)) {
+            // 新文件或格式不符，重新初始化
+            head->magic = kJournalMagic;
+            head->version = kJournalVersion;
+            head->high_watermark = -1;
+            head->record_count = 0;
+            head->capacity = capacity;
+            head->last_record_ns = 0;
+            file_.Flush();
+        }
+
+        // 进程中断时水位可能落后于最后一条记录，按记录重新校正
+        const uint64_t valid = std::min(head->record_count, head->capacity);
+        high_watermark_ = head->high_watermark;
+        for (uint64_t i = 0; i < valid; ++i) {
+            high_watermark_ = std::max(high_watermark_, records()[i]);
+        }
+        head->high_watermark = high_watermark_;
+    }
+
+    void ProcessedJournal::MarkProcessed(int64_t frame_number) {
+        Header* head = header();
+
+        // 先写记录再推进水位和计数，中断时最多丢失最后一条
+        records()[head->record_count % head->capacity] = frame_number;
+        if (frame_number > high_watermark_) {
+            high_watermark_ = frame_number;
+            head->high_watermark = frame_number;
+        }
+        head->record_count++;
+        head->last_record_ns = NowNanoseconds();
+
+        if (head->record_count % kFlushInterval == 0) {
+            file_.Flush();
+        }
+    }
+
+    void ProcessedJournal::Restart(int64_t watermark) {
+        Header* head = header();
+        head->record_count = 0;
+        head->high_watermark = watermark;
+        head->last_record_ns = NowNanoseconds();
+        high_watermark_ = watermark;
+        file_.Flush();
+    }
+
+    bool ProcessedJournal::LastRecordTime(std::filesystem::file_time_type& time) const {
+        const int64_t ns = header()->last_record_ns;
+        if (ns == 0) return false;
+        time = std::filesystem::file_time_type(std::chrono::duration_cast<std::filesystem::file_time_type::duration>(
+                std::chrono::nanoseconds(ns)));
+        return true;
+    }
+
+}  // namespace ImageProcessor
\ No newline at end of file
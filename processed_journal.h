@@ -0,0 +1,57 @@
+#ifndef PROCESSED_JOURNAL_H
+#define PROCESSED_JOURNAL_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include "mapped_file.h"
+
+namespace ImageProcessor {
+
+// 已处理帧日志：内存映射的追加式记录，按帧编号索引
+// 相机帧编号单调递增且按编号顺序输出，因此只需高水位即可 O(1) 判断是否已处理；
+// 记录区写满后从头覆盖，文件大小固定，水位以下的帧仍视为已处理
+    class ProcessedJournal {
+    public:
+        // 打开或创建日志文件，失败抛出 std::runtime_error
+        explicit ProcessedJournal(const std::string& path, uint64_t capacity = kDefaultCapacity);
+
+        // 帧是否已处理
+        bool IsProcessed(int64_t frame_number) const { return frame_number <= high_watermark_; }
+
+        // 记录一帧已处理
+        void MarkProcessed(int64_t frame_number);
+
+        // 已处理的最大帧编号，没有记录时为 -1
+        int64_t HighWatermark() const { return high_watermark_; }
+
+        // 最后一条记录写入时的文件时钟时间，没有记录时返回 false
+        // 映射写入不一定更新日志文件的修改时间，判断帧是否晚于最后一次处理时以此为准
+        bool LastRecordTime(std::filesystem::file_time_type& time) const;
+
+        // 相机帧计数重置后把水位重新设为 watermark，并丢弃旧记录（否则重新打开时会按旧记录恢复水位）
+        void Restart(int64_t watermark);
+
+        static constexpr uint64_t kDefaultCapacity = 65536;
+
+    private:
+        // 文件头，紧随其后的是 capacity 条帧编号记录
+        struct Header {
+            uint32_t magic;           // 文件标识
+            uint32_t version;         // 格式版本
+            int64_t high_watermark;   // 已处理的最大帧编号
+            uint64_t record_count;    // 累计追加的记录数
+            uint64_t capacity;        // 记录区容量
+            int64_t last_record_ns;   // 最后一条记录写入时的文件时钟时间（纳秒），没有记录时为 0
+        };
+
+        Header* header() const { return reinterpret_cast<Header*>(file_.Data()); }
+        int64_t* records() const { return reinterpret_cast<int64_t*>(file_.Data() + sizeof(Header)); }
+
+        MappedFile file_;              // 映射的日志文件
+        int64_t high_watermark_ = -1;  // 高水位缓存
+    };
+
+}  // namespace ImageProcessor
+
+#endif  // PROCESSED_JOURNAL_H
\ No newline at end of file
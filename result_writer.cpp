@@ -0,0 +1,126 @@
+#include "result_writer.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace ImageProcessor {
+
+    namespace {
+
+        // 转义 JSON 字符串中的引号、反斜杠和控制字符
+        std::string EscapeJson(const std::string& text) {
+            std::string escaped;
+            escaped.reserve(text.size());
+            for (char c : text) {
+                if (c == '"' || c == '\\') {
+                    escaped += '\\';
+                    escaped += c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    escaped += cv::format("\\u%04x", c);
+                } else {
+                    escaped += c;
+                }
+            }
+            return escaped;
+        }
+
+        // CSV 字段含逗号或引号时加引号
+        std::string EscapeCsv(const std::string& text) {
+            if (text.find_first_of(",\"\n") == std::string::npos) return text;
+
+            std::string escaped = "\"";
+            for (char c : text) {
+                if (c == '"') escaped += '"';
+                escaped += c;
+            }
+            return escaped + "\"";
+        }
+
+    }  // namespace
+
+    ResultWriter::ResultWriter(const std::string& path, ResultFormat format)
+            : out_(&std::cout), format_(format) {
+        if (path != "-") {
+            file_.open(path, std::ios::out | std::ios::app);
+            if (!file_) {
+                throw std::runtime_error("Unable to open result file: " + path);
+            }
+            out_ = &file_;
+        }
+
+        // 新文件写入 CSV 表头
+        if (format_ == ResultFormat::kCsv && (out_ != &file_ || file_.tellp() == 0)) {
+            *out_ << "frame,file,kind,i,j,x,y,radius,distance_px\n";
+        }
+    }
+
+    bool ResultWriter::ParseFormat(const std::string& name, ResultFormat& format) {
+        if (name == "jsonl" || name == "json") {
+            format = ResultFormat::kJsonLines;
+            return true;
+        }
+        if (name == "csv") {
+            format = ResultFormat::kCsv;
+            return true;
+        }
+        return false;
+    }
+
+    void ResultWriter::WriteFrame(int64_t frame_number, const std::string& filename, bool loaded,
+                                  const std::vector<cv::Vec3f>& circles,
+                                  const std::vector<CircleDistance>& distances) {
+        if (format_ == ResultFormat::kJsonLines) {
+            WriteJsonLine(frame_number, filename, loaded, circles, distances);
+        } else {
+            WriteCsvRows(frame_number, filename, loaded, circles, distances);
+        }
+        out_->flush();
+    }
+
+    void ResultWriter::WriteJsonLine(int64_t frame_number, const std::string& filename, bool loaded,
+                                     const std::vector<cv::Vec3f>& circles,
+                                     const std::vector<CircleDistance>& distances) {
+        std::ostream& out = *out_;
+        out << "{\"frame\":" << frame_number
+            << ",\"file\":\"" << EscapeJson(filename) << "\""
+            << ",\"loaded\":" << (loaded ? "true" : "false")
+            << ",\"circles\":[";
+        for (size_t i = 0; i < circles.size(); ++i) {
+            if (i > 0) out << ',';
+            out << cv::format("{\"x\":%.2f,\"y\":%.2f,\"r\":%.2f}", circles[i][0], circles[i][1], circles[i][2]);
+        }
+        out << "],\"distances\":[";
+        for (size_t i = 0; i < distances.size(); ++i) {
+            if (i > 0) out << ',';
+            out << cv::format("{\"i\":%d,\"j\":%d,\"px\":%.2f}",
+                              distances[i].first, distances[i].second, distances[i].distance);
+        }
+        out << "]}\n";
+    }
+
+    void ResultWriter::WriteCsvRows(int64_t frame_number, const std::string& filename, bool loaded,
+                                    const std::vector<cv::Vec3f>& circles,
+                                    const std::vector<CircleDistance>& distances) {
+        std::ostream& out = *out_;
+        const std::string prefix = std::to_string(frame_number) + "," + EscapeCsv(filename) + ",";
+
+        // 读取失败或未检测到圆时也写一行，保证每帧都有记录
+        if (!loaded) {
+            out << prefix << "error,,,,,,\n";
+            return;
+        }
+        if (circles.empty()) {
+            out << prefix << "empty,,,,,,\n";
+            return;
+        }
+
+        for (size_t i = 0; i < circles.size(); ++i) {
+            out << prefix << cv::format("circle,%d,,%.2f,%.2f,%.2f,\n",
+                                        static_cast<int>(i), circles[i][0], circles[i][1], circles[i][2]);
+        }
+        for (const auto& distance : distances) {
+            out << prefix << cv::format("distance,%d,%d,,,,%.2f\n",
+                                        distance.first, distance.second, distance.distance);
+        }
+    }
+
+}  // namespace ImageProcessor
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "pitch_measurement.h"
+
+namespace ImageProcessor {
+
+// 结果输出格式
+    enum class ResultFormat {
+        kJsonLines,  // 每帧一行 JSON
+        kCsv         // 每个圆/每对距离一行
+    };
+
+// 检测结果写出器，将每帧的圆和圆心距离写入文件或标准输出
+    class ResultWriter {
+    public:
+        // path 为 "-" 时写到标准输出，打开失败抛出 std::runtime_error
+        ResultWriter(const std::string& path, ResultFormat format);
+
+        // 写出一帧结果并立即刷新，便于下游逐行读取
+        void WriteFrame(int64_t frame_number, const std::string& filename, bool loaded,
+                        const std::vector<cv::Vec3f>& circles,
+                        const std::vector<CircleDistance>& distances);
+
+        // 解析格式名称（"jsonl" / "csv"），无法识别时返回 false
+        static bool ParseFormat(const std::string& name, ResultFormat& format);
+
+    private:
+        void WriteJsonLine(int64_t frame_number, const std::string& filename, bool loaded,
+                           const std::vector<cv::Vec3f>& circles,
+                           const std::vector<CircleDistance>& distances);
+        void WriteCsvRows(int64_t frame_number, const std::string& filename, bool loaded,
+                          const std::vector<cv::Vec3f>& circles,
+                          const std::vector<CircleDistance>& distances);
+
+        std::ofstream file_;     // 输出文件
+        std::ostream* out_;      // 实际输出流（文件或标准输出）
+        ResultFormat format_;    // 输出格式
+    };
+
+}  // namespace ImageProcessor
+
+#endif  // RESULT_WRITER_H
\ No newline at end of file
@@ -0,0 +1,387 @@
+#include "shared_frame_ring.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ImageProcessor {
+
+    namespace {
+
+        constexpr uint32_t kMagic = 0x52465854;  // "TXFR"
+        constexpr uint32_t kVersion = 2;
+
+        // 像素区按页对齐，每个槽位按缓存行对齐
+        constexpr size_t kPageBytes = 4096;
+        constexpr size_t kLineBytes = 64;
+
+        // 生产者等待空槽位时的轮询间隔
+        constexpr auto kPollInterval = std::chrono::microseconds(200);
+
+#ifdef _WIN32
+        // 以不同规格重建时等待消费者断开旧环的最长时间和重试间隔
+        constexpr auto kRecreateTimeout = std::chrono::seconds(2);
+        constexpr auto kRecreateInterval = std::chrono::milliseconds(10);
+#endif
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring counters must be lock-free across processes");
+
+        size_t AlignUp(size_t value, size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+#ifdef _WIN32
+        std::string ObjectName(const std::string& name) {
+            return "Local\\" + name;
+        }
+#else
+        std::string ObjectName(const std::string& name) {
+            return name.empty() || name[0] != '/' ? "/" + name : name;
+        }
+#endif
+
+    }  // namespace
+
+    // 环头部，位于映射起始处；两个计数器分属生产者和消费者，各占一条缓存行
+    struct SharedFrameRing::Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slot_count;
+        uint32_t reserved;
+        uint64_t slot_bytes;
+        uint64_t data_offset;                          // 第一个槽位像素区的偏移
+        std::atomic<uint32_t> abandoned;               // 生产者以不同规格重建时置 1
+        std::atomic<uint32_t> generation;              // 原地按新规格重新初始化的次数（仅 Windows）
+        alignas(64) std::atomic<uint64_t> write_sequence;  // 已提交的帧数（下一帧的序列号）
+        alignas(64) std::atomic<uint64_t> read_sequence;   // 消费者已连续交还的帧数
+    };
+
+    // 槽位元数据，随 write_sequence 的 release 写入对消费者可见
+    struct SharedFrameRing::Slot {
+        int64_t timestamp_us;
+        int32_t width;
+        int32_t height;
+        int32_t type;
+        int32_t reserved;
+        uint64_t step;
+    };
+
+    SharedFrameRing::~SharedFrameRing() {
+        Close();
+    }
+
+    SharedFrameRing::Header* SharedFrameRing::header() const {
+        return reinterpret_cast<Header*>(base_);
+    }
+
+    SharedFrameRing::Slot* SharedFrameRing::slot(uint64_t sequence) const {
+        return reinterpret_cast<Slot*>(base_ + AlignUp(sizeof(Header), kLineBytes)) + sequence % slot_count_;
+    }
+
+    unsigned char* SharedFrameRing::pixels(uint64_t sequence) const {
+        return base_ + data_offset_ + (sequence % slot_count_) * slot_bytes_;
+    }
+
+    bool SharedFrameRing::Create(const std::string& name, int slot_count, size_t slot_bytes) {
+        Close();
+        if (slot_count < 2 || slot_bytes == 0) return false;
+
+        slot_bytes = AlignUp(slot_bytes, kLineBytes);
+        const size_t data_offset = AlignUp(AlignUp(sizeof(Header), kLineBytes) +
+                                           static_cast<size_t>(slot_count) * sizeof(Slot), kPageBytes);
+        const size_t total = data_offset + static_cast<size_t>(slot_count) * slot_bytes;
+
+        bool created = false;
+        if (!Map(name, total, true, created)) return false;
+
+        if (!created) {
+            Header* existing = header();
+            const bool valid = size_ >= sizeof(Header) && existing->magic == kMagic && existing->version == kVersion;
+            if (valid && existing->slot_count == static_cast<uint32_t>(slot_count) &&
+                existing->slot_bytes == slot_bytes && existing->data_offset == data_offset && size_ >= total &&
+                existing->abandoned.load(std::memory_order_acquire) == 0) {
+                slot_count_ = slot_count;
+                slot_bytes_ = slot_bytes;
+                data_offset_ = data_offset;
+                generation_ = existing->generation.load(std::memory_order_acquire);
+                return true;
+            }
+
+            // 规格不同：通知仍映射着旧环的消费者重新打开，再以新规格重建
+            if (valid) existing->abandoned.store(1, std::memory_order_release);
+            Close();
+#ifdef _WIN32
+            // 命名映射无法删除也无法扩展，最后一个句柄关闭时才销毁：等待消费者断开后重新创建；
+            // 超时后仍有进程映射着旧环时，旧环足够大就按新规格原地重新初始化，否则失败
+            const auto deadline = std::chrono::steady_clock::now() + kRecreateTimeout;
+            while (true) {
+                if (!Map(name, total, true, created)) return false;
+                if (created) break;
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    if (size_ >= total) break;
+                    Close();
+                    return false;
+                }
+                Close();
+                std::this_thread::sleep_for(kRecreateInterval);
+            }
+#else
+            Remove(name);
+            if (!Map(name, total, true, created) || !created) {
+                Close();
+                return false;
+            }
+#endif
+        }
+
+        // 新建的共享内存对象内容为 0，最后写入 magic，消费者据此判断头部已初始化
+        // 原地重新初始化时先清除 magic 并推进代数：之后打开的消费者在初始化完成前失败重试，已连接的消费者据代数断开
+        Header* header;
+        uint32_t generation = 0;
+        if (created) {
+            header = new (base_) Header();
+        } else {
+            header = this->header();
+            header->magic = 0;
+            generation = header->generation.load(std::memory_order_relaxed) + 1;
+            header->generation.store(generation, std::memory_order_release);
+        }
+        header->version = kVersion;
+        header->slot_count = static_cast<uint32_t>(slot_count);
+        header->slot_bytes = slot_bytes;
+        header->data_offset = data_offset;
+        header->abandoned.store(0, std::memory_order_relaxed);
+        header->write_sequence.store(0, std::memory_order_relaxed);
+        header->read_sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = kMagic;
+
+        slot_count_ = slot_count;
+        slot_bytes_ = slot_bytes;
+        data_offset_ = data_offset;
+        generation_ = generation;
+        return true;
+    }
+
+    bool SharedFrameRing::Open(const std::string& name) {
+        Close();
+        bool created = false;
+        if (!Map(name, 0, false, created)) return false;
+
+        // 已作废的旧环立即断开，不再持有其句柄，生产者才能以新规格重建
+        const Header* header = this->header();
+        if (size_ < sizeof(Header) || header->magic != kMagic || header->version != kVersion ||
+            header->slot_count < 2 || header->abandoned.load(std::memory_order_acquire) != 0 ||
+            size_ < header->data_offset + static_cast<size_t>(header->slot_count) * header->slot_bytes) {
+            Close();
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // 布局在本地保存，环被原地重建后也只访问自己映射范围内的内存
+        slot_count_ = static_cast<int>(header->slot_count);
+        slot_bytes_ = static_cast<size_t>(header->slot_bytes);
+        data_offset_ = static_cast<size_t>(header->data_offset);
+        generation_ = header->generation.load(std::memory_order_acquire);
+
+        // 上一个消费者读出但未交还的帧会重新投递
+        std::lock_guard<std::mutex> lock(release_mutex_);
+        read_ = header->read_sequence.load(std::memory_order_acquire);
+        next_read_ = read_;
+        released_.assign(slot_count_, 0);
+        return true;
+    }
+
+    bool SharedFrameRing::Write(const cv::Mat& frame, int64_t timestamp_us, int timeout_ms) {
+        if (!base_ || frame.empty()) return false;
+        if (frame.depth() != CV_8U || (frame.channels() != 1 && frame.channels() != 3)) return false;
+        const size_t row_bytes = frame.cols * frame.elemSize();
+        if (row_bytes * frame.rows > slot_bytes_) return false;
+
+        Header* header = this->header();
+        const uint64_t sequence = header->write_sequence.load(std::memory_order_relaxed);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (sequence - header->read_sequence.load(std::memory_order_acquire) >= static_cast<uint64_t>(slot_count_)) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(kPollInterval);
+        }
+
+        Slot* target = slot(sequence);
+        target->timestamp_us = timestamp_us;
+        target->width = frame.cols;
+        target->height = frame.rows;
+        target->type = frame.type();
+        target->step = row_bytes;
+
+        unsigned char* destination = pixels(sequence);
+        if (frame.isContinuous()) {
+            std::memcpy(destination, frame.data, row_bytes * frame.rows);
+        } else {
+            for (int y = 0; y < frame.rows; ++y) {
+                std::memcpy(destination + y * row_bytes, frame.ptr(y), row_bytes);
+            }
+        }
+
+        header->write_sequence.store(sequence + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool SharedFrameRing::TryRead(FrameInfo& info, cv::Mat& frame) {
+        if (!base_ || Abandoned()) return false;
+        if (next_read_ >= header()->write_sequence.load(std::memory_order_acquire)) return false;
+
+        const Slot* source = slot(next_read_);
+        info.sequence = next_read_;
+        info.timestamp_us = source->timestamp_us;
+        info.width = source->width;
+        info.height = source->height;
+        info.type = source->type;
+        info.step = static_cast<size_t>(source->step);
+
+        // 元数据损坏时投递空帧，序列号照常推进，由下游按读取失败处理；只接受 8 位 1 / 3 通道，
+        // 其他类型值无法保证 CV_ELEM_SIZE 和 cv::Mat 构造有意义
+        const bool supported = CV_MAT_DEPTH(info.type) == CV_8U && info.type == CV_MAKETYPE(CV_8U, CV_MAT_CN(info.type)) &&
+                               (CV_MAT_CN(info.type) == 1 || CV_MAT_CN(info.type) == 3);
+        const size_t row_bytes = static_cast<size_t>(info.width) * CV_MAT_CN(info.type);
+        if (!supported || info.width <= 0 || info.height <= 0 || info.step < row_bytes ||
+            info.step * static_cast<size_t>(info.height) > slot_bytes_) {
+            frame.release();
+        } else {
+            frame = cv::Mat(info.height, info.width, info.type, pixels(next_read_), info.step);
+        }
+        ++next_read_;
+        return true;
+    }
+
+    void SharedFrameRing::Release(uint64_t sequence) {
+        std::lock_guard<std::mutex> lock(release_mutex_);
+        if (!base_ || sequence < read_) return;
+        released_[sequence % slot_count_] = 1;
+        uint64_t previous = read_;
+        while (released_[read_ % slot_count_]) {
+            released_[read_ % slot_count_] = 0;
+            ++read_;
+        }
+        // 只有本消费者写 read_sequence：值与上次写入的不同说明环已被原地重建，不能改写新环的计数
+        header()->read_sequence.compare_exchange_strong(previous, read_, std::memory_order_release,
+                                                        std::memory_order_relaxed);
+    }
+
+    bool SharedFrameRing::Abandoned() const {
+        return base_ && (header()->abandoned.load(std::memory_order_acquire) != 0 ||
+                         header()->generation.load(std::memory_order_acquire) != generation_);
+    }
+
+#ifdef _WIN32
+    bool SharedFrameRing::Map(const std::string& name, size_t size, bool create, bool& created) {
+        const std::string object_name = ObjectName(name);
+        HANDLE mapping;
+        if (create) {
+            const ULONGLONG mapping_size = size;
+            mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                         static_cast<DWORD>(mapping_size >> 32),
+                                         static_cast<DWORD>(mapping_size & 0xFFFFFFFFu), object_name.c_str());
+            created = mapping && GetLastError() != ERROR_ALREADY_EXISTS;
+        } else {
+            mapping = OpenFileMappingA(FILE_MAP_WRITE, FALSE, object_name.c_str());
+        }
+        if (!mapping) return false;
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+        MEMORY_BASIC_INFORMATION region;
+        if (!view || VirtualQuery(view, &region, sizeof(region)) == 0) {
+            if (view) UnmapViewOfFile(view);
+            CloseHandle(mapping);
+            return false;
+        }
+
+        mapping_handle_ = mapping;
+        base_ = static_cast<unsigned char*>(view);
+        size_ = static_cast<size_t>(region.RegionSize);
+        return true;
+    }
+
+    void SharedFrameRing::Close() {
+        if (base_) UnmapViewOfFile(base_);
+        if (mapping_handle_) CloseHandle(mapping_handle_);
+        base_ = nullptr;
+        size_ = 0;
+        mapping_handle_ = nullptr;
+        slot_count_ = 0;
+        slot_bytes_ = 0;
+        data_offset_ = 0;
+    }
+
+    void SharedFrameRing::Remove(const std::string&) {
+        // 命名映射随最后一个句柄自动销毁，Create 中等待消费者断开
+    }
+#else
+    bool SharedFrameRing::Map(const std::string& name, size_t size, bool create, bool& created) {
+        const std::string object_name = ObjectName(name);
+        created = false;
+        int fd = -1;
+        if (create) {
+            fd = shm_open(object_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+            if (fd >= 0) {
+                created = true;
+                if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                    close(fd);
+                    shm_unlink(object_name.c_str());
+                    return false;
+                }
+            } else if (errno != EEXIST) {
+                return false;
+            }
+        }
+        if (fd < 0) fd = shm_open(object_name.c_str(), O_RDWR, 0);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            close(fd);
+            return false;
+        }
+        const size_t mapped = static_cast<size_t>(info.st_size);
+
+        void* view = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+
+        fd_ = fd;
+        base_ = static_cast<unsigned char*>(view);
+        size_ = mapped;
+        return true;
+    }
+
+    void SharedFrameRing::Close() {
+        if (base_) munmap(base_, size_);
+        if (fd_ >= 0) close(fd_);
+        base_ = nullptr;
+        size_ = 0;
+        fd_ = -1;
+        slot_count_ = 0;
+        slot_bytes_ = 0;
+        data_offset_ = 0;
+    }
+
+    void SharedFrameRing::Remove(const std::string& name) {
+        shm_unlink(ObjectName(name).c_str());
+    }
+#endif
+
+}  // namespace ImageProcessor
\ No newline at end of file
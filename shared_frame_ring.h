@@ -0,0 +1,100 @@
+#ifndef SHARED_FRAME_RING_H
+#define SHARED_FRAME_RING_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ImageProcessor {
+
+// 共享内存帧环形缓冲区：相机进程写入未压缩的原始帧，检测进程直接在共享内存上构造 cv::Mat 头读取，
+// 省去 PNG 编码落盘和再解码。POSIX 下使用 shm_open + mmap，Windows 下使用命名的页面文件映射
+// 单生产者单消费者；消费者可乱序交还槽位，读位置按序列号连续推进后生产者才会覆盖对应槽位
+// 生产者以不同规格重建时旧环被标记作废：POSIX 下删除旧对象另建新对象；Windows 下命名映射无法删除，
+// 等待消费者断开后重建，消费者迟迟不断开时在足够大的旧映射上原地重新初始化（消费者据代数发现并重新打开）
+    class SharedFrameRing {
+    public:
+        // 一帧的元数据
+        struct FrameInfo {
+            uint64_t sequence = 0;      // 帧序列号，从 0 开始连续递增
+            int64_t timestamp_us = 0;   // 生产者写入的时间戳（微秒）
+            int width = 0;              // 宽度
+            int height = 0;             // 高度
+            int type = 0;               // cv::Mat 类型（CV_8UC1 / CV_8UC3 等）
+            size_t step = 0;            // 行字节数
+        };
+
+        SharedFrameRing() = default;
+        ~SharedFrameRing();
+
+        SharedFrameRing(const SharedFrameRing&) = delete;
+        SharedFrameRing& operator=(const SharedFrameRing&) = delete;
+
+        // 生产者：创建名为 name 的环，slot_count 个槽位，每个槽位最多容纳 slot_bytes 字节像素
+        // 已存在且规格相同时直接接续（序列号不归零，已连接的消费者不受影响）；规格不同时标记旧环作废后重建
+        // Windows 下旧映射仍被占用且容量不足新规格时返回 false
+        bool Create(const std::string& name, int slot_count, size_t slot_bytes);
+
+        // 消费者：打开已存在的环，从上次交还的位置继续读取；不存在或格式不符时返回 false
+        bool Open(const std::string& name);
+
+        // 解除映射（不删除共享内存对象）
+        void Close();
+
+        // 删除名为 name 的共享内存对象，已映射的进程不受影响（Windows 下对象随最后一个句柄自动销毁）
+        static void Remove(const std::string& name);
+
+        // 生产者：按行拷贝一帧到下一个槽位；环满时最多等待 timeout_ms 毫秒
+        // 超时、帧超出槽位容量或类型不是 8 位 1 / 3 通道时返回 false（帧被丢弃）
+        bool Write(const cv::Mat& frame, int64_t timestamp_us, int timeout_ms);
+
+        // 消费者：取下一帧，没有新帧或环已作废时返回 false；frame 直接指向共享内存，Release 之前生产者不会覆盖
+        // 元数据损坏（尺寸越界、类型不是 8 位 1 / 3 通道）时 frame 为空；只能从一个线程调用
+        bool TryRead(FrameInfo& info, cv::Mat& frame);
+
+        // 消费者：交还 sequence 所在槽位，可乱序、可从任意线程调用
+        void Release(uint64_t sequence);
+
+        // 生产者以不同规格重建了同名的环（或在原映射上原地重新初始化），此环不会再有新帧，消费者应重新 Open
+        bool Abandoned() const;
+
+        bool IsOpen() const { return base_ != nullptr; }
+        int SlotCount() const { return slot_count_; }
+        size_t SlotBytes() const { return slot_bytes_; }
+
+    private:
+        struct Header;
+        struct Slot;
+
+        // 映射共享内存对象，create 为 true 时不存在则创建并扩展到 size
+        bool Map(const std::string& name, size_t size, bool create, bool& created);
+
+        Header* header() const;
+        Slot* slot(uint64_t sequence) const;
+        unsigned char* pixels(uint64_t sequence) const;
+
+        unsigned char* base_ = nullptr;   // 映射起始地址
+        size_t size_ = 0;                 // 映射长度
+        int slot_count_ = 0;              // 槽位数
+        size_t slot_bytes_ = 0;           // 每个槽位的像素区字节数
+        size_t data_offset_ = 0;          // 像素区偏移（打开时从头部读取后不再依赖头部）
+        uint32_t generation_ = 0;         // 打开时环的代数
+#ifdef _WIN32
+        void* mapping_handle_ = nullptr;  // 映射对象句柄
+#else
+        int fd_ = -1;                     // 共享内存对象描述符
+#endif
+
+        // 消费者状态（仅本进程）
+        uint64_t next_read_ = 0;          // 下一帧的序列号
+        std::mutex release_mutex_;
+        uint64_t read_ = 0;               // 已连续交还到的序列号
+        std::vector<char> released_;      // 每个槽位是否已交还（读位置之后乱序交还的帧）
+    };
+
+}  // namespace ImageProcessor
+
+#endif  // SHARED_FRAME_RING_H
\ No newline at end of file
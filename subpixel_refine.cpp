@@ -0,0 +1,184 @@
+#include "subpixel_refine.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace SubpixelRefine {
+
+    namespace {
+
+        // 灰度 ROI 视图，(x0, y0) 为 ROI 左上角在全图中的坐标
+        struct GrayView {
+            const uchar* data;
+            size_t step;
+            int cols, rows;
+            int x0, y0;
+        };
+
+        // 双线性插值，(x, y) 为全图坐标，超出 ROI 时返回 -1
+        float Sample(const GrayView& view, double x, double y) {
+            x -= view.x0;
+            y -= view.y0;
+            const int ix = static_cast<int>(std::floor(x));
+            const int iy = static_cast<int>(std::floor(y));
+            if (ix < 0 || iy < 0 || ix + 1 >= view.cols || iy + 1 >= view.rows) return -1.f;
+            const float fx = static_cast<float>(x - ix);
+            const float fy = static_cast<float>(y - iy);
+            const uchar* p0 = view.data + static_cast<size_t>(iy) * view.step + ix;
+            const uchar* p1 = p0 + view.step;
+            const float top = p0[0] + fx * (p0[1] - p0[0]);
+            const float bottom = p1[0] + fx * (p1[1] - p1[0]);
+            return top + fy * (bottom - top);
+        }
+
+        // 代数最小二乘拟合圆 (x-a)^2 + (y-b)^2 = r^2，点数不足或退化时返回 false
+        bool FitCircle(const std::vector<cv::Point2d>& points, double& a, double& b, double& r) {
+            if (points.size() < 3) return false;
+            // 以质心为原点，改善正规方程的条件数
+            double mx = 0, my = 0;
+            for (const auto& p : points) {
+                mx += p.x;
+                my += p.y;
+            }
+            mx /= points.size();
+            my /= points.size();
+
+            double suu = 0, svv = 0, suv = 0, suuu = 0, svvv = 0, suvv = 0, svuu = 0;
+            for (const auto& p : points) {
+                const double u = p.x - mx, v = p.y - my;
+                suu += u * u;
+                svv += v * v;
+                suv += u * v;
+                suuu += u * u * u;
+                svvv += v * v * v;
+                suvv += u * v * v;
+                svuu += v * u * u;
+            }
+            const double det = suu * svv - suv * suv;
+            if (std::abs(det) < 1e-9) return false;
+            const double rhs_u = 0.5 * (suuu + suvv);
+            const double rhs_v = 0.5 * (svvv + svuu);
+            const double uc = (rhs_u * svv - rhs_v * suv) / det;
+            const double vc = (suu * rhs_v - suv * rhs_u) / det;
+            a = uc + mx;
+            b = vc + my;
+            r = std::sqrt(uc * uc + vc * vc + (suu + svv) / points.size());
+            return true;
+        }
+
+        // 精化单个圆（全图坐标），失败时返回 false
+        bool RefineOne(const GrayView& view, const Params& params, double band,
+                       double& cx, double& cy, double& radius, std::vector<cv::Point2d>& edges) {
+            edges.clear();
+            const int samples = static_cast<int>(std::ceil(band)) * 2 + 1;
+            std::vector<float> profile(samples);
+            for (int k = 0; k < params.rays; ++k) {
+                const double angle = 2 * CV_PI * k / params.rays;
+                const double dx = std::cos(angle), dy = std::sin(angle);
+
+                // 沿射线每 1 像素采样，每个采样点取切向 3 点均值抑制噪声
+                const double t0 = radius - (samples - 1) / 2;
+                bool inside = true;
+                for (int i = 0; i < samples && inside; ++i) {
+                    const double t = t0 + i;
+                    const double px = cx + t * dx, py = cy + t * dy;
+                    const float v0 = Sample(view, px - dy, py + dx);
+                    const float v1 = Sample(view, px, py);
+                    const float v2 = Sample(view, px + dy, py - dx);
+                    inside = v0 >= 0 && v1 >= 0 && v2 >= 0;
+                    profile[i] = (v0 + v1 + v2) / 3;
+                }
+                if (!inside) continue;
+
+                // 中心差分的绝对值峰值即边缘位置
+                int best = -1;
+                float best_gradient = 0;
+                for (int i = 1; i < samples - 1; ++i) {
+                    const float g = std::abs(profile[i + 1] - profile[i - 1]);
+                    if (g > best_gradient) {
+                        best_gradient = g;
+                        best = i;
+                    }
+                }
+                if (best < 2 || best > samples - 3 || best_gradient < params.min_contrast) continue;
+
+                // 抛物线插值到亚像素
+                const float left = std::abs(profile[best] - profile[best - 2]);
+                const float right = std::abs(profile[best + 2] - profile[best]);
+                const float denom = left - 2 * best_gradient + right;
+                const double offset = denom < 0 ? std::clamp(0.5 * (left - right) / denom, -0.5, 0.5) : 0.0;
+                const double t = t0 + best + offset;
+                edges.emplace_back(cx + t * dx, cy + t * dy);
+            }
+            if (static_cast<int>(edges.size()) < params.rays / 2) return false;
+
+            double a, b, r;
+            if (!FitCircle(edges, a, b, r)) return false;
+
+            // 剔除残差过大的点（毛刺、相邻圆）后重新拟合一次
+            std::vector<double> residuals;
+            residuals.reserve(edges.size());
+            for (const auto& p : edges) residuals.push_back(std::abs(std::hypot(p.x - a, p.y - b) - r));
+            std::vector<double> sorted = residuals;
+            std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+            const double limit = std::max(1.0, 3 * sorted[sorted.size() / 2]);
+            size_t kept = 0;
+            for (size_t i = 0; i < edges.size(); ++i) {
+                if (residuals[i] <= limit) edges[kept++] = edges[i];
+            }
+            edges.resize(kept);
+            if (static_cast<int>(edges.size()) < params.rays / 2 || !FitCircle(edges, a, b, r)) return false;
+
+            cx = a;
+            cy = b;
+            radius = r;
+            return true;
+        }
+
+    }  // namespace
+
+    int RefineCircles(const cv::Mat& full_image, double scale, std::vector<cv::Vec3f>& circles,
+                      const Params& params) {
+        TXMA_TRACE_SCOPE("SubpixelRefine.RefineCircles");
+        if (full_image.empty() || scale <= 0) return 0;
+
+        // 粗图像素 i 覆盖全图 [i*s, i*s + s)，像素中心相差 (s - 1) / 2
+        const double center_offset = (scale - 1) / 2;
+        const double band = params.search_band * scale;
+        const double max_shift = params.max_shift * scale;
+        const cv::Rect bounds(0, 0, full_image.cols, full_image.rows);
+
+        int refined = 0;
+        cv::Mat roi_gray;
+        std::vector<cv::Point2d> edges;
+        for (auto& circle : circles) {
+            const double coarse_x = circle[0] * scale + center_offset;
+            const double coarse_y = circle[1] * scale + center_offset;
+            const double coarse_r = circle[2] * scale;
+
+            const int half = static_cast<int>(std::ceil(coarse_r + band)) + 2;
+            const cv::Rect roi = cv::Rect(cvFloor(coarse_x) - half, cvFloor(coarse_y) - half,
+                                          2 * half + 2, 2 * half + 2) & bounds;
+            if (roi.empty()) continue;
+
+            // 只对 ROI 做灰度转换
+            if (full_image.channels() == 1) {
+                roi_gray = full_image(roi);
+            } else {
+                cv::cvtColor(full_image(roi), roi_gray, cv::COLOR_BGR2GRAY);
+            }
+            const GrayView view{roi_gray.ptr<uchar>(), roi_gray.step, roi_gray.cols, roi_gray.rows, roi.x, roi.y};
+
+            double x = coarse_x, y = coarse_y, r = coarse_r;
+            if (!RefineOne(view, params, band, x, y, r, edges)) continue;
+            if (std::hypot(x - coarse_x, y - coarse_y) > max_shift || std::abs(r - coarse_r) > band) continue;
+
+            circle[0] = static_cast<float>((x - center_offset) / scale);
+            circle[1] = static_cast<float>((y - center_offset) / scale);
+            circle[2] = static_cast<float>(r / scale);
+            ++refined;
+        }
+        return refined;
+    }
+
+}  // namespace SubpixelRefine
\ No newline at end of file
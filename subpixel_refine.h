@@ -0,0 +1,26 @@
+#ifndef SUBPIXEL_REFINE_H
+#define SUBPIXEL_REFINE_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace SubpixelRefine {
+
+    // 精化参数
+    struct Params {
+        int rays = 64;              // 每个圆的径向采样射线数
+        double search_band = 2.0;   // 沿射线在粗半径两侧搜索边缘的范围（粗图像素）
+        double max_shift = 1.5;     // 精化结果与粗结果的最大允许偏差（粗图像素），超过时保留粗结果
+        int min_contrast = 8;       // 边缘处相隔 2 像素的灰度差下限，低于此值的射线不参与拟合
+    };
+
+    // 在全分辨率图像上逐个精化粗检测得到的圆
+    // circles 为在缩小 scale 倍的图像上检测到的圆，精化后仍以粗图像素为单位写回（保留小数）
+    // 每个圆只处理周围的小 ROI：沿径向射线找梯度峰值（抛物线插值到亚像素），再用最小二乘拟合圆
+    // full_image 可为灰度或 BGR；返回成功精化的圆个数
+    int RefineCircles(const cv::Mat& full_image, double scale, std::vector<cv::Vec3f>& circles,
+                      const Params& params = Params());
+
+}  // namespace SubpixelRefine
+
+#endif  // SUBPIXEL_REFINE_H
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "synthetic_images.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Synthetic {
+
+    cv::Mat MakeCircleImage(cv::Size size, int circle_count, int radius, uint64_t seed,
+                            std::vector<cv::Vec3f>* truth) {
+        cv::RNG rng(seed);
+
+        // 背景为带低幅度噪声的浅灰色，模拟金属表面纹理
+        cv::Mat image(size, CV_8UC3);
+        cv::theRNG().state = seed;
+        cv::randn(image, cv::Scalar::all(170), cv::Scalar::all(12));
+
+        if (truth) truth->clear();
+        if (circle_count <= 0) return image;
+
+        // 网格行列数按图像宽高比分配，格子边长至少为 3 倍半径，保证圆互不重叠
+        const int cols = std::max(1, static_cast<int>(std::ceil(std::sqrt(
+                circle_count * static_cast<double>(size.width) / size.height))));
+        const int rows = (circle_count + cols - 1) / cols;
+        const double cell_w = static_cast<double>(size.width) / cols;
+        const double cell_h = static_cast<double>(size.height) / rows;
+        const double jitter = std::max(0.0, std::min(cell_w, cell_h) / 2 - radius * 1.5);
+
+        for (int i = 0; i < circle_count; ++i) {
+            const double cx = (i % cols + 0.5) * cell_w + rng.uniform(-jitter, jitter);
+            const double cy = (i / cols + 0.5) * cell_h + rng.uniform(-jitter, jitter);
+            const int shade = rng.uniform(20, 60);
+
+            // 深色圆孔加浅色倒角边缘
+            cv::circle(image, cv::Point(cvRound(cx), cvRound(cy)), radius + 2,
+                       cv::Scalar(230, 230, 230), 2, cv::LINE_AA);
+            cv::circle(image, cv::Point(cvRound(cx), cvRound(cy)), radius,
+                       cv::Scalar(shade, shade, shade), cv::FILLED, cv::LINE_AA);
+
+            if (truth) truth->emplace_back(static_cast<float>(cx), static_cast<float>(cy),
+                                           static_cast<float>(radius));
+        }
+        return image;
+    }
+
+    cv::Mat MakeBarcodeImage(cv::Size size, int bar_count, double angle, uint64_t seed,
+                             cv::RotatedRect* region) {
+        cv::RNG rng(seed);
+
+        // 先在水平画布上绘制条码：宽度 1~4 个模块随机交替的黑白条
+        const int module = std::max(2, size.width / (bar_count * 6));
+        std::vector<int> widths(static_cast<size_t>(std::max(bar_count, 1)) * 2);
+        int code_width = 0;
+        for (auto& width : widths) {
+            width = rng.uniform(1, 5) * module;
+            code_width += width;
+        }
+        const int quiet = module * 10;
+        const int code_height = std::max(module * 20, size.height / 4);
+        cv::Mat label(code_height + 2 * quiet, code_width + 2 * quiet, CV_8UC3, cv::Scalar(245, 245, 245));
+        int x = quiet;
+        for (size_t i = 0; i < widths.size(); ++i) {
+            if (i % 2 == 0) {
+                cv::rectangle(label, cv::Rect(x, quiet, widths[i], code_height), cv::Scalar(15, 15, 15), cv::FILLED);
+            }
+            x += widths[i];
+        }
+
+        // 标签缩放到不超过画面的 70%，旋转后贴到暗色带噪声背景中央
+        const double scale = std::min({1.0, 0.7 * size.width / label.cols, 0.7 * size.height / label.rows});
+        cv::Mat image(size, CV_8UC3);
+        cv::theRNG().state = seed;
+        cv::randn(image, cv::Scalar(60, 70, 80), cv::Scalar::all(10));
+
+        const cv::Point2f center(size.width / 2.0f, size.height / 2.0f);
+        cv::Mat transform = cv::getRotationMatrix2D(cv::Point2f(label.cols / 2.0f, label.rows / 2.0f), angle, scale);
+        transform.at<double>(0, 2) += center.x - label.cols / 2.0;
+        transform.at<double>(1, 2) += center.y - label.rows / 2.0;
+
+        cv::Mat warped, mask;
+        cv::warpAffine(label, warped, transform, size);
+        cv::warpAffine(cv::Mat(label.size(), CV_8UC1, cv::Scalar(255)), mask, transform, size);
+        warped.copyTo(image, mask);
+
+        if (region) {
+            *region = cv::RotatedRect(center, cv::Size2f(static_cast<float>(code_width * scale),
+                                                         static_cast<float>(code_height * scale)),
+                                      static_cast<float>(-angle));
+        }
+        return image;
+    }
+
+}  // namespace Synthetic
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef SYNTHETIC_IMAGES_H
+#define SYNTHETIC_IMAGES_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Synthetic {
+
+    // 生成带噪声背景的圆孔图像（BGR），圆心在抖动网格上互不重叠
+    // 相同参数和种子总是生成相同图像；truth 非空时返回真实圆（x, y, r）
+    cv::Mat MakeCircleImage(cv::Size size, int circle_count, int radius, uint64_t seed,
+                            std::vector<cv::Vec3f>* truth = nullptr);
+
+    // 生成贴有一维条码标签的图像（BGR），条码按 angle 度旋转后放在图像中央
+    // 相同参数和种子总是生成相同图像；region 非空时返回条码所在的旋转矩形
+    cv::Mat MakeBarcodeImage(cv::Size size, int bar_count, double angle, uint64_t seed,
+                             cv::RotatedRect* region = nullptr);
+
+}  // namespace Synthetic
+
+#endif  // SYNTHETIC_IMAGES_H
\ No newline at end of file
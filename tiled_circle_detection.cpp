@@ -0,0 +1,182 @@
+#include "tiled_circle_detection.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace TiledCircleDetection {
+
+    namespace {
+
+        constexpr size_t kFallbackL2Bytes = 512 * 1024;
+
+        // 霍夫梯度法每像素的工作集：灰度 1 + Canny 边缘 1 + Sobel dx/dy 4 + 累加器（dp = 2 时约 1）+ 余量
+        constexpr int kBytesPerPixel = 8;
+
+        // 瓦片原点对齐到该值的倍数，dp 为 1/2/4 时瓦片的累加器网格与整幅图像的网格重合
+        constexpr int kAlignment = 4;
+
+        // 接受的圆心可越出核心区的像素数，吸收相邻瓦片对同一个圆的估计差异，由合并去重
+        constexpr int kOwnershipBand = 4;
+
+        // Sobel / Canny 在窗口边缘需要的额外支撑
+        constexpr int kEdgeSupport = 2;
+
+        int AlignUp(int value) {
+            return (value + kAlignment - 1) / kAlignment * kAlignment;
+        }
+
+        // core 互不重叠地覆盖整幅图像，window 为 core 向外扩展重叠带后与图像的交集
+        struct Tile {
+            cv::Rect core;
+            cv::Rect window;
+        };
+
+        // 合并用的候选圆
+        struct Candidate {
+            cv::Vec3f circle;
+            int tile;        // 瓦片序号（行优先）
+            int rank;        // 在瓦片检测结果中的位置
+            float interior;  // 圆心到窗口内侧边界的距离，越大说明该瓦片看到的邻域越完整
+        };
+
+        // 圆心到窗口边界的最近距离，窗口贴着图像边界的一侧不计（整幅图像检测在那里同样没有邻域）
+        float InteriorDistance(const cv::Vec3f& circle, const cv::Rect& window, const cv::Size& image) {
+            float distance = std::numeric_limits<float>::max();
+            if (window.x > 0) distance = std::min(distance, circle[0] - window.x);
+            if (window.y > 0) distance = std::min(distance, circle[1] - window.y);
+            if (window.x + window.width < image.width) distance = std::min(distance, window.x + window.width - circle[0]);
+            if (window.y + window.height < image.height) distance = std::min(distance, window.y + window.height - circle[1]);
+            return distance;
+        }
+
+        size_t QueryL2CacheBytes() {
+#ifdef _WIN32
+            DWORD length = 0;
+            GetLogicalProcessorInformation(nullptr, &length);
+            std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+            if (!info.empty() && GetLogicalProcessorInformation(info.data(), &length)) {
+                for (const auto& item : info) {
+                    if (item.Relationship == RelationCache && item.Cache.Level == 2) return item.Cache.Size;
+                }
+            }
+#elif defined(_SC_LEVEL2_CACHE_SIZE)
+            const long bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+            if (bytes > 0) return static_cast<size_t>(bytes);
+#endif
+            return kFallbackL2Bytes;
+        }
+
+    }  // namespace
+
+    size_t L2CacheBytes() {
+        static const size_t bytes = QueryL2CacheBytes();
+        return bytes;
+    }
+
+    int DefaultTileSize() {
+        const int side = static_cast<int>(std::sqrt(static_cast<double>(L2CacheBytes()) / kBytesPerPixel));
+        return std::max(kAlignment, side / kAlignment * kAlignment);
+    }
+
+    void Detect(const cv::Mat& gray, const Params& params, const DetectFn& detect,
+                ImageProcessor::WorkStealingPool& pool, std::vector<cv::Vec3f>& circles) {
+        TXMA_TRACE_SCOPE("TiledCircleDetection.Detect");
+
+        // 圆心在核心区附近（±kOwnershipBand）的圆完整落在窗口内；重叠带不随 min_dist 增大，否则瓦片放不进 L2
+        const int overlap = AlignUp(params.max_radius + kOwnershipBand + kEdgeSupport);
+        const int tile_size = params.tile_size > 0 ? params.tile_size : DefaultTileSize();
+        // 核心区至少为重叠带的两倍，否则重复检测的面积超过有效面积
+        const int core_limit = AlignUp(std::max(tile_size - 2 * overlap, 2 * overlap));
+
+        const int tiles_x = (gray.cols + core_limit - 1) / core_limit;
+        const int tiles_y = (gray.rows + core_limit - 1) / core_limit;
+        if (tiles_x * tiles_y <= 1) {
+            detect(gray, circles);
+            return;
+        }
+
+        // 核心区均分图像，避免最后一列/行只剩很窄的瓦片
+        const int core_w = AlignUp((gray.cols + tiles_x - 1) / tiles_x);
+        const int core_h = AlignUp((gray.rows + tiles_y - 1) / tiles_y);
+        const cv::Rect bounds(0, 0, gray.cols, gray.rows);
+        std::vector<Tile> tiles;
+        tiles.reserve(static_cast<size_t>(tiles_x) * tiles_y);
+        for (int y = 0; y < gray.rows; y += core_h) {
+            for (int x = 0; x < gray.cols; x += core_w) {
+                Tile tile;
+                tile.core = cv::Rect(x, y, core_w, core_h) & bounds;
+                tile.window = cv::Rect(x - overlap, y - overlap, core_w + 2 * overlap, core_h + 2 * overlap) & bounds;
+                tiles.push_back(tile);
+            }
+        }
+
+        // 每个瓦片的结果写入自己的槽，合并顺序不依赖线程调度
+        std::vector<std::vector<cv::Vec3f>> found(tiles.size());
+        pool.ParallelFor(tiles.size(), [&](size_t index, int) {
+            TXMA_TRACE_SCOPE("TiledCircleDetection.Tile");
+            const Tile& tile = tiles[index];
+            std::vector<cv::Vec3f>& local = found[index];
+            detect(gray(tile.window), local);
+
+            const float left = static_cast<float>(tile.core.x - kOwnershipBand);
+            const float top = static_cast<float>(tile.core.y - kOwnershipBand);
+            const float right = static_cast<float>(tile.core.x + tile.core.width + kOwnershipBand);
+            const float bottom = static_cast<float>(tile.core.y + tile.core.height + kOwnershipBand);
+            size_t kept = 0;
+            for (cv::Vec3f circle : local) {
+                circle[0] += static_cast<float>(tile.window.x);
+                circle[1] += static_cast<float>(tile.window.y);
+                if (circle[0] < left || circle[0] >= right || circle[1] < top || circle[1] >= bottom) continue;
+                local[kept++] = circle;
+            }
+            local.resize(kept);
+        });
+
+        TXMA_TRACE_SCOPE("TiledCircleDetection.Merge");
+        std::vector<Candidate> candidates;
+        for (size_t t = 0; t < tiles.size(); ++t) {
+            for (size_t i = 0; i < found[t].size(); ++i) {
+                candidates.push_back({found[t][i], static_cast<int>(t), static_cast<int>(i),
+                                      InteriorDistance(found[t][i], tiles[t].window, gray.size())});
+            }
+        }
+
+        // 重叠带中被两个瓦片同时接受的圆：保留邻域最完整的那个，并列时取序号小的瓦片
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            if (a.interior != b.interior) return a.interior > b.interior;
+            if (a.tile != b.tile) return a.tile < b.tile;
+            return a.rank < b.rank;
+        });
+        const double merge_dist = std::max(params.min_dist, 2.0 * kOwnershipBand);
+        const float merge_dist2 = static_cast<float>(merge_dist * merge_dist);
+        std::vector<Candidate> kept;
+        kept.reserve(candidates.size());
+        for (const Candidate& candidate : candidates) {
+            // 同一瓦片内的间距已由 detect 保证，只与其他瓦片的结果比较
+            const bool duplicate = std::any_of(kept.begin(), kept.end(), [&](const Candidate& other) {
+                if (other.tile == candidate.tile) return false;
+                const float dx = other.circle[0] - candidate.circle[0];
+                const float dy = other.circle[1] - candidate.circle[1];
+                return dx * dx + dy * dy < merge_dist2;
+            });
+            if (!duplicate) kept.push_back(candidate);
+        }
+
+        std::sort(kept.begin(), kept.end(), [](const Candidate& a, const Candidate& b) {
+            return a.tile != b.tile ? a.tile < b.tile : a.rank < b.rank;
+        });
+        circles.clear();
+        circles.reserve(kept.size());
+        for (const Candidate& candidate : kept) circles.push_back(candidate.circle);
+    }
+
+}  // namespace TiledCircleDetection
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef TILED_CIRCLE_DETECTION_H
+#define TILED_CIRCLE_DETECTION_H
+
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <vector>
+#include "work_stealing_pool.h"
+
+// 分块并行圆检测：全分辨率图像切成按 L2 缓存大小确定的重叠瓦片，瓦片分发到线程池分别检测
+// 每个瓦片只负责圆心落在其核心区（互不重叠地划分整幅图像）附近的圆，重叠带由最大半径确定，圆的边缘支撑完整，
+// 结果与整幅图像一次检测一致；最小圆心间距的抑制在窗口内进行，只有 min_dist 不小于实际圆间距时才可能不同
+namespace TiledCircleDetection {
+
+    // 在灰度图（或其子区域）上执行一次圆检测，结果坐标相对于传入的图像；会被多个线程同时调用
+    using DetectFn = std::function<void(const cv::Mat& gray, std::vector<cv::Vec3f>& circles)>;
+
+    // 分块参数
+    struct Params {
+        int tile_size = 0;         // 瓦片（含重叠带）边长，0 时按 L2 缓存大小确定
+        int max_radius = 0;        // 检测的最大半径
+        double min_dist = 0.0;     // 圆心最小间距，合并重叠带中的重复圆时使用
+    };
+
+    // 当前 CPU 的 L2 缓存字节数，无法查询时返回 512 KB
+    size_t L2CacheBytes();
+
+    // 按 L2 缓存确定的瓦片边长：瓦片连同霍夫检测的梯度、边缘和累加器缓冲区能放入 L2
+    int DefaultTileSize();
+
+    // 将 gray 切块后在 pool 上检测并合并；图像不超过一个瓦片时直接调用 detect
+    // 结果按瓦片行优先顺序排列，瓦片内保持 detect 返回的顺序，与线程调度无关
+    // pool 的 ParallelFor 不可嵌套，调用方不能已处在同一个池的任务中
+    void Detect(const cv::Mat& gray, const Params& params, const DetectFn& detect,
+                ImageProcessor::WorkStealingPool& pool, std::vector<cv::Vec3f>& circles);
+
+}  // namespace TiledCircleDetection
+
+#endif  // TILED_CIRCLE_DETECTION_H
\ No newline at end of file
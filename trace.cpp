@@ -0,0 +1,235 @@
+#include "trace.h"
+
+#ifdef TXMA_ENABLE_TRACE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Trace {
+
+    namespace {
+
+        // 每个线程保留的最近事件数
+        constexpr size_t kRingCapacity = 1 << 16;
+
+        // 每个线程最多区分的阶段数
+        constexpr size_t kMaxStages = 64;
+
+        // 对数直方图：每个 2 的幂区间再细分 8 格，相对误差约 9%
+        constexpr int kSubBuckets = 8;
+        constexpr int kBucketCount = 64 * kSubBuckets;
+
+        struct Event {
+            const char* name;
+            int64_t start_ns;
+            int64_t duration_ns;
+        };
+
+        struct Histogram {
+            const char* name = nullptr;
+            uint64_t count = 0;
+            int64_t max_ns = 0;
+            std::array<uint32_t, kBucketCount> buckets{};
+        };
+
+        int BucketIndex(int64_t ns) {
+            const uint64_t value = static_cast<uint64_t>(std::max<int64_t>(ns, 1));
+            int exponent = 63;
+            while (!(value >> exponent)) --exponent;
+            const int sub = exponent >= 3 ? static_cast<int>((value >> (exponent - 3)) & (kSubBuckets - 1))
+                                          : static_cast<int>((value << (3 - exponent)) & (kSubBuckets - 1));
+            return exponent * kSubBuckets + sub;
+        }
+
+        // 桶的中点，用于估计分位数
+        double BucketMidpoint(int index) {
+            const int exponent = index / kSubBuckets;
+            const int sub = index % kSubBuckets;
+            const double base = static_cast<double>(1ULL << exponent);
+            return base * (1.0 + (sub + 0.5) / kSubBuckets);
+        }
+
+        // 单个线程的记录缓冲区，只有所属线程写入
+        struct ThreadBuffer {
+            int tid = 0;
+            std::string thread_name;
+            std::vector<Event> ring = std::vector<Event>(kRingCapacity);
+            std::atomic<uint64_t> written{0};
+            std::array<Histogram, kMaxStages> histograms;
+            size_t stage_count = 0;
+
+            Histogram* FindHistogram(const char* name) {
+                // 阶段名是字面量，先按指针比较，命中率最高
+                for (size_t i = 0; i < stage_count; ++i) {
+                    if (histograms[i].name == name) return &histograms[i];
+                }
+                if (stage_count == kMaxStages) return nullptr;
+                histograms[stage_count].name = name;
+                return &histograms[stage_count++];
+            }
+        };
+
+        // 全局登记表，线程退出后缓冲区仍由此持有，退出时统一导出
+        class Collector {
+        public:
+            static Collector& Instance() {
+                static Collector collector;
+                return collector;
+            }
+
+            ThreadBuffer* Register() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto buffer = std::make_shared<ThreadBuffer>();
+                buffer->tid = static_cast<int>(buffers_.size()) + 1;
+                buffers_.push_back(buffer);
+                return buffer.get();
+            }
+
+            std::vector<std::shared_ptr<ThreadBuffer>> Snapshot() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return buffers_;
+            }
+
+            // 进程退出时导出，此时不能再通过 Instance() 访问自身
+            ~Collector();
+
+        private:
+            std::mutex mutex_;
+            std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+        };
+
+        ThreadBuffer* LocalBuffer() {
+            thread_local ThreadBuffer* buffer = Collector::Instance().Register();
+            return buffer;
+        }
+
+        std::string EscapeJson(const char* text) {
+            std::string escaped;
+            for (const char* c = text; *c; ++c) {
+                if (*c == '"' || *c == '\\') escaped += '\\';
+                escaped += *c;
+            }
+            return escaped;
+        }
+
+        bool DumpBuffers(const std::vector<std::shared_ptr<ThreadBuffer>>& buffers, const std::string& path) {
+            std::ofstream out(path);
+            if (!out) {
+                std::cerr << "Unable to write trace file: " << path << std::endl;
+                return false;
+            }
+
+            // 以最早事件为时间零点，Chrome trace 时间单位为微秒
+            int64_t origin = INT64_MAX;
+            for (const auto& buffer : buffers) {
+                const uint64_t written = buffer->written.load(std::memory_order_acquire);
+                const uint64_t first = written > kRingCapacity ? written - kRingCapacity : 0;
+                for (uint64_t i = first; i < written; ++i) {
+                    origin = std::min(origin, buffer->ring[i % kRingCapacity].start_ns);
+                }
+            }
+
+            out << "{\"traceEvents\":[";
+            bool first_event = true;
+            for (const auto& buffer : buffers) {
+                if (!buffer->thread_name.empty()) {
+                    out << (first_event ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                        << buffer->tid << ",\"args\":{\"name\":\"" << EscapeJson(buffer->thread_name.c_str()) << "\"}}";
+                    first_event = false;
+                }
+
+                const uint64_t written = buffer->written.load(std::memory_order_acquire);
+                const uint64_t first = written > kRingCapacity ? written - kRingCapacity : 0;
+                for (uint64_t i = first; i < written; ++i) {
+                    const Event& event = buffer->ring[i % kRingCapacity];
+                    char line[256];
+                    std::snprintf(line, sizeof(line), "\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                                  buffer->tid, (event.start_ns - origin) / 1000.0, event.duration_ns / 1000.0);
+                    out << (first_event ? "" : ",") << "\n{\"name\":\"" << EscapeJson(event.name) << "\"," << line;
+                    first_event = false;
+                }
+            }
+            out << "\n]}\n";
+            return static_cast<bool>(out);
+        }
+
+        void PrintBuffers(const std::vector<std::shared_ptr<ThreadBuffer>>& buffers) {
+            // 按阶段名合并各线程的直方图
+            std::map<std::string, Histogram> merged;
+            for (const auto& buffer : buffers) {
+                for (size_t i = 0; i < buffer->stage_count; ++i) {
+                    const Histogram& source = buffer->histograms[i];
+                    Histogram& target = merged[source.name];
+                    target.count += source.count;
+                    target.max_ns = std::max(target.max_ns, source.max_ns);
+                    for (int b = 0; b < kBucketCount; ++b) target.buckets[b] += source.buckets[b];
+                }
+            }
+            if (merged.empty()) return;
+
+            auto percentile = [](const Histogram& histogram, double q) {
+                const auto target = static_cast<uint64_t>(q * static_cast<double>(histogram.count - 1)) + 1;
+                uint64_t seen = 0;
+                for (int b = 0; b < kBucketCount; ++b) {
+                    seen += histogram.buckets[b];
+                    if (seen >= target) return BucketMidpoint(b);
+                }
+                return static_cast<double>(histogram.max_ns);
+            };
+
+            std::fprintf(stderr, "\n%-40s %10s %12s %12s %12s\n", "stage", "count", "p50 (ms)", "p99 (ms)", "max (ms)");
+            for (const auto& [name, histogram] : merged) {
+                std::fprintf(stderr, "%-40s %10llu %12.3f %12.3f %12.3f\n", name.c_str(),
+                             static_cast<unsigned long long>(histogram.count),
+                             percentile(histogram, 0.50) / 1e6, percentile(histogram, 0.99) / 1e6,
+                             histogram.max_ns / 1e6);
+            }
+        }
+
+        Collector::~Collector() {
+            const char* path = std::getenv("TXMA_TRACE_FILE");
+            DumpBuffers(buffers_, path ? path : "txma_trace.json");
+            PrintBuffers(buffers_);
+        }
+
+    }  // namespace
+
+    void Record(const char* name, int64_t start_ns, int64_t end_ns) {
+        ThreadBuffer* buffer = LocalBuffer();
+        const int64_t duration = end_ns - start_ns;
+
+        const uint64_t index = buffer->written.load(std::memory_order_relaxed);
+        buffer->ring[index % kRingCapacity] = {name, start_ns, duration};
+        buffer->written.store(index + 1, std::memory_order_release);
+
+        if (Histogram* histogram = buffer->FindHistogram(name)) {
+            histogram->count++;
+            histogram->max_ns = std::max(histogram->max_ns, duration);
+            histogram->buckets[BucketIndex(duration)]++;
+        }
+    }
+
+    void SetThreadName(const std::string& name) {
+        LocalBuffer()->thread_name = name;
+    }
+
+    bool DumpChromeTrace(const std::string& path) {
+        return DumpBuffers(Collector::Instance().Snapshot(), path);
+    }
+
+    void PrintHistograms() {
+        PrintBuffers(Collector::Instance().Snapshot());
+    }
+
+}  // namespace Trace
+
+#endif  // TXMA_ENABLE_TRACE
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// 低开销分段计时：TXMA_ENABLE_TRACE 未定义时所有宏展开为空，不产生任何开销
+// 启用后每个线程写入各自的环形缓冲区，进程退出时导出 Chrome trace JSON
+// （chrome://tracing 或 Perfetto 打开）并在标准错误打印各阶段 p50/p99
+
+#ifdef TXMA_ENABLE_TRACE
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Trace {
+
+    // 当前时间（纳秒，单调时钟）
+    inline int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 记录一段耗时，name 必须是字符串字面量（只保存指针）
+    void Record(const char* name, int64_t start_ns, int64_t end_ns);
+
+    // 设置当前线程在 trace 中显示的名称
+    void SetThreadName(const std::string& name);
+
+    // 立即导出 Chrome trace JSON，应在工作线程停止后调用
+    // 进程退出时会自动导出到环境变量 TXMA_TRACE_FILE 指定的路径，默认 txma_trace.json
+    bool DumpChromeTrace(const std::string& path);
+
+    // 打印各阶段耗时分布（次数、p50、p99、最大值），应在工作线程停止后调用
+    void PrintHistograms();
+
+    // 作用域计时器，析构时记录
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const char* name) : name_(name), start_ns_(NowNs()) {}
+        ~ScopedTimer() { Record(name_, start_ns_, NowNs()); }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        const char* name_;
+        int64_t start_ns_;
+    };
+
+}  // namespace Trace
+
+#define TXMA_TRACE_CONCAT_INNER(a, b) a##b
+#define TXMA_TRACE_CONCAT(a, b) TXMA_TRACE_CONCAT_INNER(a, b)
+#define TXMA_TRACE_SCOPE(name) ::Trace::ScopedTimer TXMA_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TXMA_TRACE_THREAD(name) ::Trace::SetThreadName(name)
+
+#else
+
+#define TXMA_TRACE_SCOPE(name) ((void)0)
+#define TXMA_TRACE_THREAD(name) ((void)0)
+
+#endif  // TXMA_ENABLE_TRACE
+
+#endif  // TRACE_H
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "work_stealing_pool.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace ImageProcessor {
+
+    WorkStealingPool::WorkStealingPool(int threads) {
+        if (threads <= 0) {
+            threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        }
+        // 调用线程占用最后一个槽位
+        for (int i = 0; i < threads; ++i) {
+            ranges_.push_back(std::make_unique<Range>());
+        }
+        for (int i = 0; i + 1 < threads; ++i) {
+            workers_.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    WorkStealingPool& WorkStealingPool::Shared() {
+        static WorkStealingPool pool;
+        return pool;
+    }
+
+    void WorkStealingPool::ParallelFor(size_t count, const std::function<void(size_t index, int slot)>& body) {
+        if (count == 0) return;
+        std::lock_guard<std::mutex> run_lock(run_mutex_);
+
+        // 按槽位均分初始区间
+        const size_t slots = ranges_.size();
+        for (size_t i = 0; i < slots; ++i) {
+            std::lock_guard<std::mutex> lock(ranges_[i]->mutex);
+            ranges_[i]->begin = count * i / slots;
+            ranges_[i]->end = count * (i + 1) / slots;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            body_ = &body;
+            error_ = nullptr;
+            active_ = static_cast<int>(workers_.size());
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        RunSlot(static_cast<int>(slots) - 1);
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this] { return active_ == 0; });
+            body_ = nullptr;
+            error = error_;
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+    WorkStealingPool::Stats WorkStealingPool::GetStats() const {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return stats_;
+    }
+
+    void WorkStealingPool::WorkerLoop(int slot) {
+        TXMA_TRACE_THREAD("WorkStealingPool");
+        uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+                if (stopping_) return;
+                seen = generation_;
+            }
+
+            RunSlot(slot);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_ == 0) done_.notify_all();
+        }
+    }
+
+    void WorkStealingPool::RunSlot(int slot) {
+        const auto& body = *body_;
+        uint64_t tasks = 0, steals = 0;
+        while (true) {
+            size_t index;
+            if (TakeOwn(slot, index)) {
+                try {
+                    body(index, slot);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!error_) error_ = std::current_exception();
+                }
+                ++tasks;
+                continue;
+            }
+            if (!Steal(slot)) break;
+            ++steals;
+        }
+
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.tasks += tasks;
+        stats_.steals += steals;
+    }
+
+    bool WorkStealingPool::TakeOwn(int slot, size_t& index) {
+        Range& range = *ranges_[slot];
+        std::lock_guard<std::mutex> lock(range.mutex);
+        if (range.begin >= range.end) return false;
+        index = range.begin++;
+        return true;
+    }
+
+    bool WorkStealingPool::Steal(int slot) {
+        // 从下一个槽位开始轮询，找到剩余任务最多的区间，取走后一半
+        const int slots = static_cast<int>(ranges_.size());
+        while (true) {
+            int victim = -1;
+            size_t largest = 0;
+            for (int k = 1; k < slots; ++k) {
+                const int i = (slot + k) % slots;
+                std::lock_guard<std::mutex> lock(ranges_[i]->mutex);
+                const size_t remaining = ranges_[i]->end - std::min(ranges_[i]->begin, ranges_[i]->end);
+                if (remaining > largest) {
+                    largest = remaining;
+                    victim = i;
+                }
+            }
+            if (victim < 0) return false;
+
+            size_t begin, end;
+            {
+                Range& range = *ranges_[victim];
+                std::lock_guard<std::mutex> lock(range.mutex);
+                if (range.begin >= range.end) continue;  // 扫描后已被取完，重新选择
+                const size_t mid = range.begin + (range.end - range.begin) / 2;
+                begin = mid;
+                end = range.end;
+                range.end = mid;
+            }
+
+            Range& own = *ranges_[slot];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = begin;
+            own.end = end;
+            return true;
+        }
+    }
+
+}  // namespace ImageProcessor
\ No newline at end of file
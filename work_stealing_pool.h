@@ -0,0 +1,78 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ImageProcessor {
+
+// 工作窃取线程池，用于批量离线处理
+// 每个执行槽位持有一段连续的下标区间，从区间头部逐个取任务；自己的区间取完后
+// 从其他槽位的区间尾部窃取一半，处理时间不均的图像也能让各线程同时结束
+    class WorkStealingPool {
+    public:
+        // 执行槽位总数 = 后台线程数 + 1（调用线程也参与执行），threads 为 0 时按硬件线程数确定
+        explicit WorkStealingPool(int threads = 0);
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        // 进程内共享的池
+        static WorkStealingPool& Shared();
+
+        // 执行槽位数，ParallelFor 传给 body 的 slot 取值范围为 [0, Concurrency())
+        int Concurrency() const { return static_cast<int>(workers_.size()) + 1; }
+
+        // 对 [0, count) 的每个下标调用 body(index, slot)，全部完成后返回
+        // 同一 slot 不会被两个线程同时使用，可据此为每个线程分配独立状态
+        // body 抛出的第一个异常在所有任务结束后重新抛出；多个线程同时调用时串行执行，不可嵌套调用
+        void ParallelFor(size_t count, const std::function<void(size_t index, int slot)>& body);
+
+        // 统计信息
+        struct Stats {
+            uint64_t tasks = 0;    // 执行的任务数
+            uint64_t steals = 0;   // 成功窃取的次数
+        };
+        Stats GetStats() const;
+
+    private:
+        // 一个槽位的待处理区间 [begin, end)
+        struct Range {
+            std::mutex mutex;
+            size_t begin = 0;
+            size_t end = 0;
+        };
+
+        void WorkerLoop(int slot);
+        void RunSlot(int slot);
+        bool TakeOwn(int slot, size_t& index);
+        bool Steal(int slot);
+
+        std::vector<std::thread> workers_;
+        std::vector<std::unique_ptr<Range>> ranges_;
+
+        std::mutex run_mutex_;   // 串行化 ParallelFor
+        std::mutex mutex_;       // 保护以下状态
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        const std::function<void(size_t, int)>* body_ = nullptr;
+        uint64_t generation_ = 0;
+        int active_ = 0;         // 仍在执行当前任务的后台线程数
+        bool stopping_ = false;
+        std::exception_ptr error_;
+
+        mutable std::mutex stats_mutex_;
+        Stats stats_;
+    };
+
+}  // namespace ImageProcessor
+
+#endif  // WORK_STEALING_POOL_H
\ No newline at end of file